@@ -19,73 +19,162 @@
 #pragma once
 
 #include <vector>
-#include <random>
 #include <queue>
 #include <iostream>
 #include <utility>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+
+#include "Random.h"
 
 // Double-Precision Floating-Point-Number representing a probability.
 // This must (!) be in the interval [0,1].
 using probability = double;
 
+// Index of a slot in an alias-table.
+using AliasIndex = std::uint32_t;
+
+
+// Batch-sampling kernels (see src/AliasTable.cpp). The fastest kernel supported by the CPU is selected at runtime,
+//      all kernels produce exactly the same indices as repeated scalar draws.
+enum class AliasKernel {
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+AliasKernel alias_kernel();
+
+bool alias_kernel_supported(AliasKernel kernel);
+
+void alias_fill(AliasKernel kernel, std::span<const probability> thresholds, std::span<const AliasIndex> aliases,
+                CounterRng &rng, std::span<AliasIndex> out);
+
+// Draw the index of a single element: A uniform slot, then either the slot itself or its alias.
+inline AliasIndex alias_draw(const std::span<const probability> thresholds, const std::span<const AliasIndex> aliases,
+                             CounterRng &rng) {
+    const auto slot = static_cast<AliasIndex>(rng.scaled(thresholds.size()));
+    const probability r_bias = rng.uniform(); // Half-open intervall [0, 1)
+    return (r_bias < thresholds[slot]) ? slot : aliases[slot];
+}
+
+
+// The table is stored as a structure of arrays: For every slot i, the element i is drawn with probability thresholds[i],
+//      the element aliases[i] otherwise. The arrays are immutable after construction and either owned by the table
+//      or borrowed from another storage (e.g. a memory-mapped file), which is kept alive by the table.
+//      Copies of a table share the arrays. Drawing only reads the table, the randomness is passed in by the caller,
+//      so a single table can be shared by any number of threads.
 template<typename T>
 class AliasTable {
 private:
     unsigned long long size;
 
-    std::mt19937 gen;
-    std::uniform_real_distribution<double> distr;
-
-    std::vector<std::pair<probability, T> > probTable;
-    std::vector<T> aliasTable;
+    std::span<const probability> thresholds;
+    std::span<const AliasIndex> aliases;
+    std::span<const T> elements;
+    std::shared_ptr<const void> storage;
 
 public:
     explicit AliasTable(std::vector<std::pair<probability, T> > elements);
 
+    AliasTable(std::vector<probability> thresholds, std::vector<AliasIndex> aliases, std::vector<T> elements);
+
+    AliasTable(std::span<const probability> thresholds, std::span<const AliasIndex> aliases,
+               std::span<const T> elements, std::shared_ptr<const void> storage);
+
     AliasTable();
 
-    T& getElement();
+    const T& getElement(CounterRng &rng) const;
+
+    // Draw out.size() elements at once, storing their positions in get_elements().
+    //      Same result (and state of rng afterwards) as out.size() calls of getElement(), but vectorized.
+    void fill(CounterRng &rng, std::span<AliasIndex> out) const;
+
+    std::span<const probability> get_thresholds() const;
+
+    std::span<const AliasIndex> get_aliases() const;
+
+    std::span<const T> get_elements() const;
 };
 
 // Default initialization. Initializes the Table with the Default-Value for the given Type T.
 // Really only used as a dummy value for member-variables.
 template<typename T>
-AliasTable<T>::AliasTable() {
-    this->probTable.push_back(std::make_pair(1.0f, T()));
-    this->size = 1;
+AliasTable<T>::AliasTable() : AliasTable(std::vector<probability>{1.0}, std::vector<AliasIndex>{0}, std::vector<T>{T()}) {}
+
+
+// Construct a table from precomputed arrays, which are copied into the table.
+template<typename T>
+AliasTable<T>::AliasTable(std::vector<probability> thresholds, std::vector<AliasIndex> aliases,
+                          std::vector<T> elements) {
+    auto arrays = std::make_shared<std::tuple<std::vector<probability>, std::vector<AliasIndex>, std::vector<T> > >(
+        std::move(thresholds), std::move(aliases), std::move(elements));
+    *this = AliasTable(std::get<0>(*arrays), std::get<1>(*arrays), std::get<2>(*arrays), arrays);
+}
+
+
+// Construct a table on top of precomputed arrays, which are borrowed from the given storage.
+template<typename T>
+AliasTable<T>::AliasTable(std::span<const probability> thresholds, std::span<const AliasIndex> aliases,
+                          std::span<const T> elements, std::shared_ptr<const void> storage) {
+    if (thresholds.empty() || thresholds.size() != aliases.size() || thresholds.size() != elements.size())
+        throw std::invalid_argument("The arrays of an alias-table must be non-empty and of equal size.");
+    for (const AliasIndex alias : aliases)
+        if (alias >= thresholds.size())
+            throw std::invalid_argument("Alias-table contains an alias outside of the table.");
+
+    this->size = thresholds.size();
+    this->thresholds = thresholds;
+    this->aliases = aliases;
+    this->elements = elements;
+    this->storage = std::move(storage);
 }
 
 
 template<typename T>
 AliasTable<T>::AliasTable(std::vector<std::pair<probability, T> > elements) {
-    // Initialize the RNG
     this->size = elements.size();
-    this->gen = std::mt19937(std::random_device{}());
-    this->distr = std::uniform_real_distribution<double>(0.0f, 1.0f); // Half-open intervall [0, 1)
+    if (this->size == 0 || this->size > std::numeric_limits<AliasIndex>::max())
+        throw std::invalid_argument("An alias-table needs between 1 and 2^32-1 elements.");
+
+    // Slot i of the table belongs to the i-th given element.
+    std::vector<probability> slot_thresholds(this->size, 1.0);
+    std::vector<AliasIndex> slot_aliases(this->size);
+    std::vector<T> slot_elements;
+    slot_elements.reserve(this->size);
+    for (AliasIndex i = 0; i < this->size; i++) {
+        slot_aliases[i] = i;
+        slot_elements.push_back(std::move(elements[i].second));
+    }
 
     // Preprocessing: Sort the given Elements into a larger/smaller-queue by the average-probability 1/n.
-    std::queue<std::pair<probability, T> > smaller;
-    std::queue<std::pair<probability, T> > larger;
+    std::queue<std::pair<probability, AliasIndex> > smaller;
+    std::queue<std::pair<probability, AliasIndex> > larger;
     double avg_prob = 1.0f / this->size;
 
-    for (unsigned long long i = 0; i < this->size; i++) {
+    for (AliasIndex i = 0; i < this->size; i++) {
         if (elements[i].first < avg_prob) {
-            smaller.push(elements[i]);
+            smaller.push(std::make_pair(elements[i].first, i));
         } else {
-            larger.push(elements[i]);
+            larger.push(std::make_pair(elements[i].first, i));
         }
     }
 
     // Construction of the Tables
     // Default-Case: A smaller and larger element are paired
     while (smaller.size() > 0 && larger.size() > 0) {
-        std::pair<probability, T> s = smaller.front();
-        std::pair<probability, T> l = larger.front();
+        std::pair<probability, AliasIndex> s = smaller.front();
+        std::pair<probability, AliasIndex> l = larger.front();
 
-        // Construct an entry with a small element in the ProbTable and a large element in the aliasTable
+        // The slot of the small element keeps it with its (normalized) probability, the large element is the alias.
         // Probabilities are scaled by 1/n to normalize to 1.
-        this->probTable.push_back(std::make_pair(s.first / avg_prob, s.second));
-        this->aliasTable.push_back(l.second);
+        slot_thresholds[s.second] = s.first / avg_prob;
+        slot_aliases[s.second] = l.second;
 
         // Reclassify the large element into the proper queue, depending on the remaining probability
         l.first = (l.first + s.first) - avg_prob;
@@ -100,40 +189,38 @@ AliasTable<T>::AliasTable(std::vector<std::pair<probability, T> > elements) {
     }
 
     // Remainder-Case: Only larger elements remain, which should have exactly the right size.
-    // Numerical differences may occur and are ignored.
-    while (larger.size() > 0) {
-        std::pair<probability, T> l = larger.front();
-        this->probTable.push_back(std::make_pair(1.0f, l.second));
-        larger.pop();
-    }
-
+    // Numerical differences may occur and are ignored. Their slots keep the threshold 1 and never use the alias.
     // "Impossible"-Case: Only smaller elements remain. This can only occur due to numerical inaccuracies.
     // Any values here should be exactly 1 as well.
-    while (smaller.size() > 0) {
-        std::pair<probability, T> s = smaller.front();
-        this->probTable.push_back(std::make_pair(1.0f, s.second));
-        smaller.pop();
-    }
 
-    // To preempt any index-errors, the size is set to the size of the probability-table.
-    // This *should* not matter, if it does, something went wrong.
-    if (this->size != this->probTable.size()) {
-        std::clog << "Difference in the expected and actual size of an alias-table: Expected " << this->size <<
-                ", actually got " << this->probTable.size() << ".";
-    }
-    this->size = this->probTable.size();
+    *this = AliasTable(std::move(slot_thresholds), std::move(slot_aliases), std::move(slot_elements));
 }
 
 
 template<typename T>
-T& AliasTable<T>::getElement() {
-    probability r_idx = this->distr(this->gen);
-    probability r_bias = this->distr(this->gen);
-    int idx = static_cast<int>(std::floor(this->size * r_idx));
-
-    if (r_bias < this->probTable[idx].first) {
-        return this->probTable[idx].second;
-    } else {
-        return this->aliasTable[idx];
-    }
+const T& AliasTable<T>::getElement(CounterRng &rng) const {
+    return this->elements[alias_draw(this->thresholds, this->aliases, rng)];
+}
+
+
+template<typename T>
+void AliasTable<T>::fill(CounterRng &rng, std::span<AliasIndex> out) const {
+    static const AliasKernel kernel = alias_kernel();
+    alias_fill(kernel, this->thresholds, this->aliases, rng, out);
+}
+
+
+template<typename T>
+std::span<const probability> AliasTable<T>::get_thresholds() const {
+    return this->thresholds;
+}
+
+template<typename T>
+std::span<const AliasIndex> AliasTable<T>::get_aliases() const {
+    return this->aliases;
+}
+
+template<typename T>
+std::span<const T> AliasTable<T>::get_elements() const {
+    return this->elements;
 }
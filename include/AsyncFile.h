@@ -0,0 +1,121 @@
+/*
+    Asynchronous output of a file, decoupling the generating threads from the disk.
+
+    Data is copied into buffers of a fixed pool. Full buffers are queued and written by a dedicated I/O-thread, while
+    the callers continue with the next free buffer. Only if all buffers are queued, write() waits for the I/O-thread
+    (backpressure), so at most queue_depth buffers are in memory. The I/O-thread submits the buffers with io_uring if
+    available (GRAPHGEN_HAVE_URING, detected by CMake), keeping all queued buffers in flight, and with pwrite otherwise.
+    With the direct option, the file is opened with O_DIRECT to bypass the page-cache, if the file-system supports it.
+
+    Many files, e.g. the partitions of an output, can share the I/O-thread and the pool of an AsyncIO. Every open file
+    adds the buffer it fills to the pool, the queue_depth buffers in flight are shared.
+*/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct AsyncFileOptions {
+    // Size of a single buffer, rounded up to a multiple of the block-size for O_DIRECT.
+    size_t buffer_size = size_t{4} << 20;
+    // Number of buffers, i.e. the number of writes in flight plus the buffer being filled.
+    size_t queue_depth = 8;
+    // Bypass the page-cache (O_DIRECT).
+    bool direct = false;
+};
+
+
+class AsyncFile;
+
+// I/O-thread and buffer pool, shared by the AsyncFiles created with it.
+class AsyncIO {
+public:
+    explicit AsyncIO(const AsyncFileOptions &options);
+
+    AsyncIO(const AsyncIO &) = delete;
+    AsyncIO &operator=(const AsyncIO &) = delete;
+
+    // All files have to be closed before, they keep the AsyncIO alive.
+    ~AsyncIO();
+
+private:
+    friend class AsyncFile;
+
+    struct Request {
+        AsyncFile *file;
+        char *buffer;
+        size_t length;
+        uint64_t offset;
+    };
+
+    size_t buffer_size;
+    // Number of writes in flight, fixed by the constructor.
+    size_t queue_depth;
+
+    // Buffers of the pool, block-aligned. The pool grows and shrinks with the number of open files.
+    std::vector<char *> buffers;
+    std::vector<char *> free_buffers;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Request> queue;
+    bool closing = false;
+    std::string error;
+    std::thread io_thread;
+
+    void add_buffer();
+    void remove_buffer(std::unique_lock<std::mutex> &lock);
+    char *acquire();
+    void submit(const Request &request);
+    void run();
+    void run_pwrite();
+    void run_uring();
+    void complete(const Request &request, long result);
+};
+
+
+class AsyncFile {
+public:
+    // The file gets its own I/O-thread and pool, unless an AsyncIO is given.
+    AsyncFile(const std::string &filepath, const AsyncFileOptions &options, std::shared_ptr<AsyncIO> io = nullptr);
+
+    AsyncFile(const AsyncFile &) = delete;
+    AsyncFile &operator=(const AsyncFile &) = delete;
+
+    ~AsyncFile();
+
+    // Append the data to the file. Not thread-safe, concurrent callers have to be synchronized.
+    void write(const char *data, size_t length);
+
+    // Write all remaining data and close the file. Errors of the I/O-thread are thrown here or by write().
+    //      With a shared AsyncIO, an error of any of its files is reported by all of them.
+    void close();
+
+private:
+    friend class AsyncIO;
+
+    std::shared_ptr<AsyncIO> io;
+    std::string path;
+    int fd = -1;
+    bool direct = false;
+
+    // Buffer currently being filled by write().
+    char *current = nullptr;
+    size_t fill = 0;
+    uint64_t offset = 0;
+
+    // Queued or running writes of this file, guarded by the mutex of the AsyncIO.
+    size_t pending = 0;
+
+    void submit(size_t length);
+};
@@ -0,0 +1,39 @@
+/*
+    Binary graph format, read with READER_TYPE=BINARY.
+    A graph is stored in two files in the format of BinaryIO.h (little-endian, arrays length-prefixed and 8-byte aligned):
+
+        Node-File:  uint64 NODES_MAGIC, uint64 version, uint64 #types,  #types  strings, NodeRecord-array
+        Edge-File:  uint64 EDGES_MAGIC, uint64 version, uint64 #colors, #colors strings, EdgeRecord-array
+
+    Types/Colors are stored once by name, the records refer to them by their position in the file.
+    The record-arrays have a fixed width, so they are used in place from the memory-mapping.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+
+// Identification of binary graph files ("GGNODES"/"GGEDGES" + 0x01).
+constexpr uint64_t BINARY_NODES_MAGIC = 0x015345444F4E4747;
+constexpr uint64_t BINARY_EDGES_MAGIC = 0x0153454744454747;
+constexpr uint64_t BINARY_GRAPH_VERSION = 1;
+
+
+struct NodeRecord {
+    uint64_t id;
+    uint32_t type;
+    uint32_t reserved;
+};
+
+struct EdgeRecord {
+    uint64_t start;
+    uint64_t end;
+    uint32_t color;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(NodeRecord) == 16 && std::is_trivially_copyable_v<NodeRecord>);
+static_assert(sizeof(EdgeRecord) == 24 && std::is_trivially_copyable_v<EdgeRecord>);
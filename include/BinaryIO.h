@@ -0,0 +1,221 @@
+/*
+    Helpers for the binary file formats of the generator (model snapshots, compiled models, binary graphs).
+    All values are written as fixed-width little-endian integers/IEEE-754 doubles. Arrays are prefixed with their
+    length (uint64) and aligned to 8 bytes, so they can be used in place from a memory-mapping.
+*/
+
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "AliasTable.h"
+#include "MappedFile.h"
+
+static_assert(std::endian::native == std::endian::little, "The binary formats are only supported on little-endian hosts.");
+
+
+// Sequential writer for the binary formats.
+class BinaryOut {
+private:
+    std::ofstream file;
+    std::string path;
+    uint64_t pos = 0;
+
+public:
+    explicit BinaryOut(const std::string &filepath);
+
+    template<typename T>
+    void put(T value);
+
+    void put_bytes(const void *data, size_t length);
+
+    void put_string(std::string_view s);
+
+    template<typename T>
+    void put_array(std::span<const T> values);
+
+    void align(size_t alignment = 8);
+
+    uint64_t position() const;
+
+    void close();
+};
+
+
+// Bounds-checked sequential reader for the binary formats, reading from a memory-mapping of the whole file.
+// The mapping is shared, so views returned by view_array() stay valid as long as a copy of mapping() is kept.
+class BinaryIn {
+private:
+    std::shared_ptr<const MappedFile> file;
+    std::string path;
+    uint64_t pos = 0;
+
+    const char *take(size_t length);
+
+public:
+    explicit BinaryIn(const std::string &filepath);
+
+    template<typename T>
+    T get();
+
+    std::string get_string();
+
+    template<typename T>
+    std::vector<T> get_array();
+
+    template<typename T>
+    std::span<const T> view_array();
+
+    void align(size_t alignment = 8);
+
+    uint64_t position() const;
+
+    uint64_t size() const;
+
+    std::shared_ptr<const MappedFile> mapping() const;
+};
+
+
+
+
+inline BinaryOut::BinaryOut(const std::string &filepath) : path(filepath) {
+    this->file.open(filepath, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!this->file.is_open())
+        throw std::runtime_error("Could not open '" + filepath + "' for writing.");
+}
+
+template<typename T>
+void BinaryOut::put(const T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    this->put_bytes(&value, sizeof(T));
+}
+
+inline void BinaryOut::put_bytes(const void *data, const size_t length) {
+    this->file.write(static_cast<const char *>(data), static_cast<std::streamsize>(length));
+    this->pos += length;
+}
+
+inline void BinaryOut::put_string(const std::string_view s) {
+    this->put<uint64_t>(s.size());
+    this->put_bytes(s.data(), s.size());
+    this->align();
+}
+
+template<typename T>
+void BinaryOut::put_array(std::span<const T> values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    this->put<uint64_t>(values.size());
+    this->put_bytes(values.data(), values.size_bytes());
+    this->align();
+}
+
+inline void BinaryOut::align(const size_t alignment) {
+    static constexpr char zeros[64] = {};
+    if (const size_t rest = this->pos % alignment; rest != 0)
+        this->put_bytes(zeros, alignment - rest);
+}
+
+inline uint64_t BinaryOut::position() const {
+    return this->pos;
+}
+
+inline void BinaryOut::close() {
+    this->file.close();
+    if (this->file.fail())
+        throw std::runtime_error("Error while writing '" + this->path + "'.");
+}
+
+
+
+
+inline BinaryIn::BinaryIn(const std::string &filepath) : path(filepath) {
+    this->file = std::make_shared<const MappedFile>(filepath);
+}
+
+inline const char *BinaryIn::take(const size_t length) {
+    if (length > this->file->size() - this->pos)
+        throw std::runtime_error("Unexpected end of file in '" + this->path + "'. Is the file truncated?");
+    const char *p = this->file->data() + this->pos;
+    this->pos += length;
+    return p;
+}
+
+template<typename T>
+T BinaryIn::get() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    std::memcpy(&value, this->take(sizeof(T)), sizeof(T));
+    return value;
+}
+
+inline std::string BinaryIn::get_string() {
+    const auto length = this->get<uint64_t>();
+    std::string s(this->take(length), length);
+    this->align();
+    return s;
+}
+
+template<typename T>
+std::vector<T> BinaryIn::get_array() {
+    const std::span<const T> values = this->view_array<T>();
+    return std::vector<T>(values.begin(), values.end());
+}
+
+template<typename T>
+std::span<const T> BinaryIn::view_array() {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+    const auto length = this->get<uint64_t>();
+    if (length > (this->file->size() - this->pos) / sizeof(T))
+        throw std::runtime_error("Unexpected end of file in '" + this->path + "'. Is the file truncated?");
+    const auto *values = reinterpret_cast<const T *>(this->take(length * sizeof(T)));
+    this->align();
+    return {values, length};
+}
+
+inline void BinaryIn::align(const size_t alignment) {
+    if (const size_t rest = this->pos % alignment; rest != 0)
+        this->take(alignment - rest);
+}
+
+inline uint64_t BinaryIn::position() const {
+    return this->pos;
+}
+
+inline uint64_t BinaryIn::size() const {
+    return this->file->size();
+}
+
+inline std::shared_ptr<const MappedFile> BinaryIn::mapping() const {
+    return this->file;
+}
+
+
+
+
+// Write the arrays of an alias-table with trivially copyable elements.
+template<typename T>
+void save_alias_table(BinaryOut &out, const AliasTable<T> &table) {
+    out.put_array<probability>(table.get_thresholds());
+    out.put_array<AliasIndex>(table.get_aliases());
+    out.put_array<T>(table.get_elements());
+}
+
+// Load an alias-table written by save_alias_table(). The table uses the arrays in place, without copying them.
+template<typename T>
+AliasTable<T> load_alias_table(BinaryIn &in) {
+    const std::span<const probability> thresholds = in.view_array<probability>();
+    const std::span<const AliasIndex> aliases = in.view_array<AliasIndex>();
+    const std::span<const T> elements = in.view_array<T>();
+    return AliasTable<T>(thresholds, aliases, elements, in.mapping());
+}
@@ -0,0 +1,48 @@
+/*
+    Support for compressed inputs and outputs. Formats are detected by their magic bytes, not by the file-extension.
+    gzip requires zlib (GRAPHGEN_HAVE_ZLIB), zstd requires libzstd (GRAPHGEN_HAVE_ZSTD), both are detected by CMake.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+
+enum class Compression {
+    NONE,
+    GZIP,
+    ZSTD,
+};
+
+
+// Detect the compression of a file from its first bytes.
+Compression detect_compression(std::string_view content);
+
+std::string compression_name(Compression compression);
+
+
+// Streaming decompression of an in-memory (e.g. memory-mapped) compressed file.
+// Concatenated gzip-members/zstd-frames are decompressed as one continuous stream.
+class Decompressor {
+public:
+    virtual ~Decompressor() = default;
+
+    // Decompress up to 'capacity' bytes into 'out'. Returns the number of bytes written, 0 only at the end of the stream.
+    virtual size_t read(char *out, size_t capacity) = 0;
+
+    static std::unique_ptr<Decompressor> create(Compression compression, std::string_view input);
+};
+
+
+// Compression of independent blocks, e.g. by many threads at once. Every block becomes a complete gzip-member or
+//      zstd-frame, so the concatenated blocks form a standard multi-member/multi-frame file.
+//      A level of 0 selects the default level of the format.
+std::string compress_block(Compression compression, std::string_view data, int level = 0);
+
+// A block of the format without any compression. Its size only depends on the size of the data, e.g. to replace a
+//      header in place.
+std::string store_block(Compression compression, std::string_view data);
@@ -7,17 +7,24 @@
 #include <fstream>
 #include <regex>
 
+#include "Compression.h"
+
 #ifndef CONFIGPARSER_H
     #define CONFIGPARSER_H
 
     enum INPUT_TYPE {
       I_EMPTY,
       I_TSV,        // Tab-Seperated-Value files
+      I_TSV_PARALLEL, // Tab-Seperated-Value files, memory-mapped and parsed in parallel
+      I_BINARY,     // Fixed-width binary node-/edge-records (see BinaryGraph.h)
+      I_SNAPSHOT,   // Preprocessed model, previously saved with MODEL_SNAPSHOT=...
+      I_COMPILED,   // Scaled generator model, previously saved with COMPILED_MODEL=...
     };
 
     enum OUTPUT_TYPE {
       O_EMPTY,
       O_TSV,        // Tab-Seperated-Value files
+      O_BINARY,     // Fixed-width binary node-/edge-records (see BinaryGraph.h)
       O_BENCHMARK,  // Voids any input and provides some analytics
     };
 
@@ -27,11 +34,52 @@
 
       float scalingFactor = 0.0;
 
+      // Scaling-factor of a previously generated graph, which is extended to the scalingFactor (0: no base-graph).
+      float base_scalingFactor = 0.0;
+
       unsigned rng_seed = 0;
 
       std::string output_file_nodes = "generated_nodes.tsv";
       std::string output_file_edges = "generated_edges.tsv";
 
+      // Snapshot of the preprocessed model: Loaded with READER_TYPE=SNAPSHOT, otherwise written after preprocessing.
+      std::string model_snapshot;
+
+      // Upper bound for the per-node state while reading the input in MiB. 0 reads the input exactly.
+      unsigned long long ingest_memory_budget = 0;
+
+      // Compiled (scaled) model: Loaded with READER_TYPE=COMPILED, otherwise written before generation.
+      std::string compiled_model;
+
+      // Generate no self-loops and no multi-edges within a color. The drawn edges held at once are limited to a
+      //      memory budget in MiB (0: no limit), further buckets of a color are handled in more passes.
+      bool simple_graph = false;
+      unsigned long long simple_graph_memory_budget = 0;
+
+      // Sort the edges of every color by source and target, within a memory budget in MiB. Shards are sorted separately.
+      //      Sorted runs exceeding the budget are spilled to the given directory (default: the system's temp-directory).
+      bool sort_output = false;
+      unsigned long long sort_memory_budget = 1024;
+      std::string sort_directory;
+
+      // Asynchronous output of the TSV-writer: size of a buffer in KiB, number of buffers and O_DIRECT.
+      unsigned long long output_buffer_size = 4096;
+      unsigned long long output_queue_depth = 8;
+      bool output_direct_io = false;
+
+      // Compression of the output-files in independent blocks (level 0: default level of the format).
+      Compression output_compression = Compression::NONE;
+      int output_compression_level = 0;
+
+      // Split the output of TSV- and binary-writers into files per edge color and/or OUTPUT_PARTITIONS ranges of IDs.
+      bool output_partition_by_color = false;
+      unsigned long long output_partitions = 1;
+
+      // Only generate the shard SHARD_INDEX of SHARD_COUNT disjoint shards of the graph.
+      //      Only the files of the TSV-output without partitions can be concatenated to those of a single run.
+      long long shard_index = 0;
+      long long shard_count = 1;
+
       INPUT_TYPE reader_type = I_EMPTY;
       OUTPUT_TYPE writer_type = O_EMPTY;
     };
@@ -60,6 +108,14 @@
 
       if (s == "TSV")
         return INPUT_TYPE::I_TSV;
+      if (s == "PARALLEL_TSV")
+        return INPUT_TYPE::I_TSV_PARALLEL;
+      if (s == "BINARY")
+        return INPUT_TYPE::I_BINARY;
+      if (s == "SNAPSHOT")
+        return INPUT_TYPE::I_SNAPSHOT;
+      if (s == "COMPILED")
+        return INPUT_TYPE::I_COMPILED;
 
       return INPUT_TYPE::I_EMPTY;
     }
@@ -70,6 +126,8 @@
 
       if (s == "TSV")
         return OUTPUT_TYPE::O_TSV;
+      if (s == "BINARY")
+        return OUTPUT_TYPE::O_BINARY;
       if (s == "BENCHMARK")
         return OUTPUT_TYPE::O_BENCHMARK;
 
@@ -110,6 +168,14 @@
             std::cerr << "[WARNING] Could not convert scaling factor'" << line << "' to float. (Line " << line_no << ")." << std::endl;
           }
 
+        } else if (attr == "BASE_SCALE") {
+          try {
+            line = clean_string(line);
+            cfg.base_scalingFactor = std::stof(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert base scaling factor'" << line << "' to float. (Line " << line_no << ")." << std::endl;
+          }
+
         } else if (attr == "RNG_SEED") {
           try {
             line = clean_string(line);
@@ -124,6 +190,118 @@
         } else if (attr == "OUTPUT_EDGE_FILE") {
           cfg.output_file_edges = clean_string(line);
 
+        } else if (attr == "MODEL_SNAPSHOT") {
+          cfg.model_snapshot = clean_string(line);
+
+        } else if (attr == "COMPILED_MODEL") {
+          cfg.compiled_model = clean_string(line);
+
+        } else if (attr == "INGEST_MEMORY_BUDGET") {
+          try {
+            line = clean_string(line);
+            cfg.ingest_memory_budget = std::stoull(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert memory budget '" << line << "' to MiB. (Line " << line_no << ")." << std::endl;
+          }
+
+        } else if (attr == "SIMPLE_GRAPH") {
+          line = to_upper(clean_string(line));
+          if (line == "TRUE" || line == "YES" || line == "1")
+            cfg.simple_graph = true;
+          else if (line == "FALSE" || line == "NO" || line == "0")
+            cfg.simple_graph = false;
+          else
+            std::cerr << "[WARNING] Could not convert '" << line << "' to TRUE/FALSE. (Line " << line_no << ")." << std::endl;
+
+        } else if (attr == "SIMPLE_GRAPH_MEMORY_BUDGET") {
+          try {
+            line = clean_string(line);
+            cfg.simple_graph_memory_budget = std::stoull(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert memory budget '" << line << "' to MiB. (Line " << line_no << ")." << std::endl;
+          }
+
+        } else if (attr == "SORT_OUTPUT") {
+          line = to_upper(clean_string(line));
+          if (line == "TRUE" || line == "YES" || line == "1")
+            cfg.sort_output = true;
+          else if (line == "FALSE" || line == "NO" || line == "0")
+            cfg.sort_output = false;
+          else
+            std::cerr << "[WARNING] Could not convert '" << line << "' to TRUE/FALSE. (Line " << line_no << ")." << std::endl;
+
+        } else if (attr == "SORT_MEMORY_BUDGET") {
+          try {
+            line = clean_string(line);
+            cfg.sort_memory_budget = std::stoull(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert memory budget '" << line << "' to MiB. (Line " << line_no << ")." << std::endl;
+          }
+
+        } else if (attr == "SORT_DIRECTORY") {
+          cfg.sort_directory = clean_string(line);
+
+        } else if (attr == "OUTPUT_BUFFER_SIZE" || attr == "OUTPUT_QUEUE_DEPTH") {
+          try {
+            line = clean_string(line);
+            (attr == "OUTPUT_BUFFER_SIZE" ? cfg.output_buffer_size : cfg.output_queue_depth) = std::stoull(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert '" << line << "' to a number. (Line " << line_no << ")." << std::endl;
+          }
+
+        } else if (attr == "OUTPUT_DIRECT_IO") {
+          line = to_upper(clean_string(line));
+          if (line == "TRUE" || line == "YES" || line == "1")
+            cfg.output_direct_io = true;
+          else if (line == "FALSE" || line == "NO" || line == "0")
+            cfg.output_direct_io = false;
+          else
+            std::cerr << "[WARNING] Could not convert '" << line << "' to TRUE/FALSE. (Line " << line_no << ")." << std::endl;
+
+        } else if (attr == "OUTPUT_COMPRESSION") {
+          line = to_upper(clean_string(line));
+          if (line == "GZIP")
+            cfg.output_compression = Compression::GZIP;
+          else if (line == "ZSTD")
+            cfg.output_compression = Compression::ZSTD;
+          else if (line == "NONE" || line.empty())
+            cfg.output_compression = Compression::NONE;
+          else
+            std::cerr << "[WARNING] Unknown compression '" << line << "', expected GZIP, ZSTD or NONE. (Line " << line_no << ")." << std::endl;
+
+        } else if (attr == "OUTPUT_COMPRESSION_LEVEL") {
+          try {
+            line = clean_string(line);
+            cfg.output_compression_level = std::stoi(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert compression level '" << line << "' to a number. (Line " << line_no << ")." << std::endl;
+          }
+
+        } else if (attr == "OUTPUT_PARTITION_BY_COLOR") {
+          line = to_upper(clean_string(line));
+          if (line == "TRUE" || line == "YES" || line == "1")
+            cfg.output_partition_by_color = true;
+          else if (line == "FALSE" || line == "NO" || line == "0")
+            cfg.output_partition_by_color = false;
+          else
+            std::cerr << "[WARNING] Could not convert '" << line << "' to TRUE/FALSE. (Line " << line_no << ")." << std::endl;
+
+        } else if (attr == "OUTPUT_PARTITIONS") {
+          try {
+            line = clean_string(line);
+            cfg.output_partitions = std::stoull(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert partitions '" << line << "' to a number. (Line " << line_no << ")." << std::endl;
+          }
+
+        } else if (attr == "SHARD_INDEX" || attr == "SHARD_COUNT") {
+          try {
+            line = clean_string(line);
+            (attr == "SHARD_INDEX" ? cfg.shard_index : cfg.shard_count) = std::stoll(line);
+          } catch (const std::exception& e) {
+            std::cerr << "[WARNING] Could not convert shard '" << line << "' to an integer. (Line " << line_no << ")." << std::endl;
+          }
+
         } else if (attr == "READER_TYPE") {
           INPUT_TYPE t = parse_input_type(line);
           cfg.reader_type = t;
@@ -149,24 +327,79 @@
 
       // Basic checks to prevent faulty configurations
       std::string err;
-      if (cfg.node_files.empty())
-        err += "At least one node-file must be provided in the configuration file."
-               "Use NODE_FILE=... to specify one or more filepaths.\n\n";
-      if (cfg.edge_files.empty())
-        err += "At least one edge-file must be provided in the configuration file."
-               "Use EDGE_FILE=... to specify one or more filepaths.\n\n";
-
-      if (cfg.scalingFactor <= 0.0)
-        err += "Scaling factor must be provided and positive."
-               "Use SCALE=X.XX to specify the scaling of the generated graph relative to the input graph.\n\n";
-      else if (cfg.scalingFactor <= 1)
-        std::cerr << "[WARNING] A scaling-factor >1 is recommended. You might run into runtime-issues or large amounts"
-                  << " of duplicate edges. Use at your own risk!" << std::endl;
+      if (cfg.reader_type == INPUT_TYPE::I_COMPILED) {
+        if (cfg.compiled_model.empty())
+          err += "The reader-type 'COMPILED' requires the path to a compiled model."
+                 "Use COMPILED_MODEL=... to specify it.\n\n";
+      } else if (cfg.reader_type == INPUT_TYPE::I_SNAPSHOT) {
+        if (cfg.model_snapshot.empty())
+          err += "The reader-type 'SNAPSHOT' requires the path to a model-snapshot."
+                 "Use MODEL_SNAPSHOT=... to specify it.\n\n";
+      } else {
+        if (cfg.node_files.empty())
+          err += "At least one node-file must be provided in the configuration file."
+                 "Use NODE_FILE=... to specify one or more filepaths.\n\n";
+        if (cfg.edge_files.empty())
+          err += "At least one edge-file must be provided in the configuration file."
+                 "Use EDGE_FILE=... to specify one or more filepaths.\n\n";
+      }
+
+      // The scaling factor of a compiled model is fixed when compiling it.
+      if (cfg.reader_type != INPUT_TYPE::I_COMPILED) {
+        if (cfg.scalingFactor <= 0.0)
+          err += "Scaling factor must be provided and positive."
+                 "Use SCALE=X.XX to specify the scaling of the generated graph relative to the input graph.\n\n";
+        else if (cfg.scalingFactor <= 1)
+          std::cerr << "[WARNING] A scaling-factor >1 is recommended. You might run into runtime-issues or large amounts"
+                    << " of duplicate edges. Use at your own risk!" << std::endl;
+      }
+
+      if (cfg.base_scalingFactor != 0.0) {
+        if (cfg.reader_type == INPUT_TYPE::I_COMPILED)
+          err += "A compiled model is fixed to the scaling factor it has been compiled with and can not extend a graph. "
+                 "Use the model-snapshot or the input-files together with BASE_SCALE instead.\n\n";
+        else if (!cfg.compiled_model.empty())
+          err += "A compiled model only stores full graphs, the model extending a graph by BASE_SCALE can not be "
+                 "compiled. Remove COMPILED_MODEL=... or BASE_SCALE=...\n\n";
+        else if (cfg.base_scalingFactor < 0.0 || cfg.base_scalingFactor >= cfg.scalingFactor)
+          err += "The base scaling factor must be positive and smaller than the scaling factor."
+                 "Use BASE_SCALE=X.XX to specify the scaling of the previously generated graph.\n\n";
+        if (cfg.rng_seed == 0)
+          err += "Extending a graph requires the RNG-Seed it has been generated with. "
+                 "Use RNG_SEED=... to specify it.\n\n";
+      }
 
       if (cfg.rng_seed == 0)
         std::cout << "[INFO] No RNG-Seed given, using system time to initialize randomness instead. "
                   << " If you want reproducible results, set the config option RNG_SEED=... to a non-empty value.\n";
 
+      if (cfg.shard_count < 1 || cfg.shard_index < 0 || cfg.shard_index >= cfg.shard_count)
+        err += "Invalid shard " + std::to_string(cfg.shard_index) + " of " + std::to_string(cfg.shard_count) + ". "
+               "SHARD_COUNT must be positive and SHARD_INDEX between 0 and SHARD_COUNT-1.\n\n";
+
+      if (cfg.sort_output && cfg.sort_memory_budget == 0)
+        err += "Sorting the output requires a positive memory budget. Use SORT_MEMORY_BUDGET=... to specify it in MiB.\n\n";
+
+      if (cfg.output_buffer_size == 0 || cfg.output_queue_depth < 2)
+        err += "The asynchronous output needs buffers of a positive OUTPUT_BUFFER_SIZE (in KiB) and an "
+               "OUTPUT_QUEUE_DEPTH of at least 2 buffers.\n\n";
+
+      // Fail before reading the input, not at the first written batch.
+#ifndef GRAPHGEN_HAVE_ZLIB
+      if (cfg.output_compression == Compression::GZIP)
+        err += "OUTPUT_COMPRESSION=GZIP requires gzip-support, but this build has been compiled without zlib.\n\n";
+#endif
+#ifndef GRAPHGEN_HAVE_ZSTD
+      if (cfg.output_compression == Compression::ZSTD)
+        err += "OUTPUT_COMPRESSION=ZSTD requires zstd-support, but this build has been compiled without libzstd.\n\n";
+#endif
+      if (cfg.output_compression != Compression::NONE && cfg.writer_type == OUTPUT_TYPE::O_BENCHMARK)
+        std::cerr << "[WARNING] OUTPUT_COMPRESSION is ignored by WRITER_TYPE=BENCHMARK, which writes no files."
+                  << std::endl;
+
+      if (cfg.output_partitions == 0)
+        err += "The output needs at least one partition. Use OUTPUT_PARTITIONS=1 to write a single file.\n\n";
+
       if (cfg.output_file_nodes.empty())
         err += "An empty string has been passed as the path for the generated node-file."
                "Does your configuration contain a stray 'OUTPUT_NODE_FILE=' without a value?\n\n";
@@ -177,11 +410,11 @@
       if (cfg.reader_type == INPUT_TYPE::I_EMPTY)
         err += "The reader-type has not been set. Use READER_TYPE=TYPE to specify the reader that "
                "should be used to parse the file.\n"
-               "\tAvailable Types: 'TSV'\n\n";
+               "\tAvailable Types: 'TSV', 'PARALLEL_TSV', 'BINARY', 'SNAPSHOT', 'COMPILED'\n\n";
       if (cfg.writer_type == OUTPUT_TYPE::O_EMPTY)
         err += "The writer-type has not been set. Use WRITER_TYPE=TYPE to specify the writer that "
                "should be used to produce the output-files in the desired format.\n"
-               "\tAvailable Types: 'TSV', 'BENCHMARK'\n\n";
+               "\tAvailable Types: 'TSV', 'BINARY', 'BENCHMARK'\n\n";
 
       if (!err.empty())
         throw std::runtime_error("One ore more problems have been encountered while parsing the config-file.\n" + err);
@@ -190,4 +423,20 @@
     }
 
 
+    // Parse the shard "i/N" given with --shard, overriding SHARD_INDEX/SHARD_COUNT of the config.
+    inline void parse_shard(const std::string &shard, Config &cfg) {
+      const size_t sep = shard.find('/');
+      try {
+        if (sep == std::string::npos)
+          throw std::invalid_argument("missing '/'");
+        cfg.shard_index = std::stoll(shard.substr(0, sep));
+        cfg.shard_count = std::stoll(shard.substr(sep + 1));
+      } catch (const std::exception &e) {
+        throw std::invalid_argument("Could not parse the shard '" + shard + "', expected --shard INDEX/COUNT.");
+      }
+      if (cfg.shard_count < 1 || cfg.shard_index < 0 || cfg.shard_index >= cfg.shard_count)
+        throw std::invalid_argument("Invalid shard '" + shard + "', expected 0 <= INDEX < COUNT.");
+    }
+
+
 #endif //CONFIGPARSER_H
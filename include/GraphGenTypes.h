@@ -2,14 +2,26 @@
 
 #include <vector>
 #include <string>
+#include <span>
+#include <string_view>
 #include <map>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <fstream>
 #include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 #include "AliasTable.h"
+#include "AsyncFile.h"
+#include "Compression.h"
+
+class BinaryIn;
+class BinaryOut;
+class WritableMappedFile;
 
 using Edgecolor = std::string;
 using Nodetype = std::string;
@@ -20,6 +32,83 @@ using Count = long long;
 using Degree = long long;
 using Index = long long;
 
+// Number of nodes for every occurring degree, sorted by ascending degree.
+using DegreeHistogram = std::vector<std::pair<Degree, Count> >;
+
+// Inclusive range [first, last] of NodeIDs
+struct IdRange {
+    NodeID first;
+    NodeID last;
+};
+
+
+// Transparent hashing for string-keyed maps: Lookups with a std::string_view need no temporary std::string.
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(const std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+template<typename V>
+using StringMap = std::unordered_map<std::string, V, StringHash, std::equal_to<> >;
+
+
+// Maps strings to dense indices [0, n) in order of their first occurrence and back.
+// Used to replace Node-Types and Edge-Colors by small integers everywhere past the readers.
+class Interner {
+public:
+    Index intern(std::string_view name);
+
+    Index find(std::string_view name) const;
+
+    const std::string &name(Index idx) const;
+
+    Index size() const;
+
+private:
+    StringMap<Index> indices;
+    std::vector<std::string> names;
+};
+
+
+// Rows of one chunk of the input, interned into local indices (see ParallelTSVReader).
+// Chunks are filled concurrently and without any access to the InputModel, InputModel::merge() then only maps the
+//      local indices to the global ones. The names are views into the text of the chunk, which has to outlive it.
+class InputChunk {
+public:
+    void readNode(std::string_view node, std::string_view node_type);
+
+    void readEdge(std::string_view start, std::string_view end, std::string_view color);
+
+private:
+    friend class InputModel;
+
+    // Endpoints are given by their canonical numeric ID (>= 0), which is cheap to look up in the model anyway,
+    //      or by -1 - the local index of their name.
+    struct LocalEdge {
+        NodeID start;
+        NodeID end;
+        Index color;
+    };
+
+    NodeID node_key(std::string_view node);
+
+    static Index local_index(std::unordered_map<std::string_view, Index> &indices,
+                             std::vector<std::string_view> &names, std::string_view name);
+
+    // Node-Names, Types and Colors in the order of their first occurrence in the chunk.
+    std::unordered_map<std::string_view, Index> name_indices;
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, Index> type_indices;
+    std::vector<std::string_view> types;
+    std::unordered_map<std::string_view, Index> color_indices;
+    std::vector<std::string_view> colors;
+
+    // Rows in their order, with local types/colors: (node, type) and (start, end, color).
+    std::vector<std::pair<NodeID, Index> > nodes;
+    std::vector<LocalEdge> edges;
+};
+
 
 class InputModel {
 public:
@@ -27,9 +116,24 @@ public:
 
     explicit InputModel(const std::string &filepath);
 
-    void readNode(const std::string &node, const std::string &color);
+    void readNode(std::string_view node, std::string_view node_type);
+
+    void readEdge(std::string_view start, std::string_view end, std::string_view color);
+
+    // Integer-API for binary inputs: Nodes are identified by their numeric ID, Types/Colors by their interned index.
+    void readNode(NodeID node, Index type);
 
-    void readEdge(const std::string &start, const std::string &end, const Edgecolor &color);
+    void readEdge(NodeID start, NodeID end, Index color);
+
+    // Add the rows of a chunk, with the same result as reading them one by one.
+    void merge(const InputChunk &chunk);
+
+    // Intern a Node-Type/Edge-Color and create its counters. Returns the index used by the integer-API.
+    Index type_index(std::string_view node_type);
+
+    Index color_index(std::string_view color);
+
+    void enable_sampling(size_t memory_budget_bytes);
 
     void preprocess();
 
@@ -37,26 +141,65 @@ public:
 
     bool is_preprocessed;
     Count node_count{};
-    std::unordered_map<Edgecolor, Count> edge_count;
 
-    // Number of Type-Type-Transitions for each Edge-Color
-    std::unordered_map<Edgecolor, std::map<std::pair<Nodetype, Nodetype>, Count> > sbm_matrix;
+    // Every Node-Type/Edge-Color is interned on first sight. All containers below are indexed by these indices.
+    Interner types;
+    Interner colors;
 
-    // Preprocessed Degree-"Buckets"
-    std::unordered_map<Nodetype, std::unordered_map<Edgecolor, std::unordered_map<Degree, Count> > > in_distribution;
-    std::unordered_map<Nodetype, std::unordered_map<Edgecolor, std::unordered_map<Degree, Count> > > out_distribution;
+    // Number of Edges for every Edge-Color
+    std::vector<Count> edge_count;
 
-    // Count the number of occurrences for every Type/Color to calculate a distribution in the end.
-    std::unordered_map<Nodetype, Count> node_types;
-    std::unordered_set<Edgecolor> edge_colors;
+    // Number of Type-Type-Transitions for each Edge-Color, as a flat (types x types)-matrix in row-major order.
+    std::vector<std::vector<Count> > sbm_matrix;
+
+    // Preprocessed Degree-"Buckets", indexed by [Node-Type][Edge-Color].
+    // Non-empty histograms start with the number of zero-degree nodes of the type.
+    std::vector<std::vector<DegreeHistogram> > in_distribution;
+    std::vector<std::vector<DegreeHistogram> > out_distribution;
+
+    // Count the number of occurrences for every Type to calculate a distribution in the end.
+    std::vector<Count> node_types;
 
 private:
-    // Save the nodeType for every read node. Needed later to map the edges to the correct node-type
-    std::unordered_map<std::string, Nodetype> nodes_to_types;
+    // Look up the dense index of the given node. Unknown nodes are registered with the given type, or "" if -1.
+    Index node_index(std::string_view node, Index new_type = -1);
+
+    Index node_index(NodeID node, Index new_type = -1);
+
+    template<typename Key>
+    void add_node(Key node, Index type);
 
-    // Count Incoming/Outgoing Edges for every Node
-    std::unordered_map<Edgecolor, std::map<std::string, Count> > in_degrees;
-    std::unordered_map<Edgecolor, std::map<std::string, Count> > out_degrees;
+    template<typename StartKey, typename EndKey>
+    void add_edge(StartKey start, EndKey end, Index color);
+
+    // Dense index of every read node. Needed later to map the edges to the correct node-type
+    //      Numeric IDs (integer-API, or canonical decimal strings like "42") are kept apart from all other IDs:
+    //      Small IDs index the vector directly (-1 if unknown), only large/sparse IDs are hashed.
+    StringMap<Index> node_ids;
+    std::vector<Index> dense_node_ids;
+    std::unordered_map<NodeID, Index> numeric_node_ids;
+
+    // Type of every node, indexed by the dense node index
+    std::vector<Index> node_type_of;
+
+    // Count Incoming/Outgoing Edges for every Color and Node, indexed by the dense color/node indices.
+    // All per-node state is released by preprocess(), only the histograms are kept.
+    std::vector<std::vector<Count> > in_degrees;
+    std::vector<std::vector<Count> > out_degrees;
+
+    // Approximate ingestion within a memory budget (see enable_sampling()).
+    //      Only nodes whose hash has at least sample_level leading zero-bits are tracked, i.e. a fraction 2^-level.
+    //      Type-Transitions are counted separately for every level of the edge, [Color][Level][Transition],
+    //      so they can be dropped exactly whenever the level is raised.
+    void enforce_memory_budget();
+
+    size_t tracked_bytes() const;
+
+    size_t memory_budget = 0;
+    int sample_level = 0;
+    size_t long_id_bytes = 0;
+    unsigned reads_since_check = 0;
+    std::vector<std::vector<std::vector<Count> > > sbm_levels;
 };
 
 
@@ -84,30 +227,102 @@ class TSVReader : public GraphReader {
 };
 
 
+// Parallel Reader for "Tab-Separated-Values"-Files (.tsv)
+// All files are memory-mapped and split into newline-aligned chunks, which are tokenized and interned concurrently.
+// The chunks are merged into the InputModel in file order, so the result is identical to the TSVReader.
+// gzip/zstd-compressed files are decompressed by a background thread, overlapping with the parsing.
+class ParallelTSVReader : public GraphReader {
+    using GraphReader::GraphReader;
+
+    public:
+        void readTo(InputModel &model) override;
+};
+
+
+// Reader for the binary graph format (see BinaryGraph.h)
+// The fixed-width records are used in place from a memory-mapping, no text has to be parsed.
+class BinaryReader : public GraphReader {
+    using GraphReader::GraphReader;
+
+    public:
+        void readTo(InputModel &model) override;
+};
+
+
+// Transition between two Node-Types, given by their positions in the NodeTypes of the GraphModel.
+struct TypeTransition {
+    uint32_t start;
+    uint32_t end;
+};
+
+
 // Container for the Transition-Probabilities for a single Type of Edge
 class EdgeDistribution {
     private:
-        AliasTable<std::pair<Nodetype, Nodetype> > transitions;
+        AliasTable<TypeTransition> transitions;
 
     public:
-        EdgeDistribution(std::unordered_map<Nodetype, Count> nodes,
-                         const std::map<std::pair<Nodetype, Nodetype>, Count> &edges);
+        EdgeDistribution(const std::vector<Count> &nodes, const std::map<std::pair<Index, Index>, Count> &edges);
+
+        explicit EdgeDistribution(BinaryIn &in);
 
         EdgeDistribution();
 
         ~EdgeDistribution() = default;
 
-        std::pair<Nodetype, Nodetype> getTransition();
+        const TypeTransition &getTransition(CounterRng &rng) const;
+
+        // Draw the transitions of a whole batch of edges at once, see getTransitionByIndex().
+        void sampleTransitions(CounterRng &rng, std::span<AliasIndex> out) const;
+
+        const TypeTransition &getTransitionByIndex(AliasIndex idx) const;
+
+        std::span<const TypeTransition> getTransitions() const;
+
+        void save(BinaryOut &out) const;
+};
+
+
+// Everything needed to draw an endpoint of one Node-Type for one Edge-Color: The degree-distribution and the
+//      (a,b)-Hash onto the IDs of the type. Built once per color before the generation, so drawing needs no lookups.
+struct NodeSampler {
+    const AliasTable<IdRange> *distribution = nullptr;
+    Number a{};
+    Number b{};
+    Number p{};
+    Number offset{};
+    Number size{};
+
+    NodeID draw(CounterRng &rng) const {
+        while (true) {
+            // Roll a range of IDs, pick one ID at uniform from that range
+            const IdRange &range = this->distribution->getElement(rng);
+            NodeID nodeid = range.first + static_cast<NodeID>(rng.below(range.last - range.first + 1));
+
+            // Apply the Permutation-Function (a,b)-Hash to the id. For p <= 2^32, a*id+b fits into 64 bits.
+            const auto a_u = static_cast<uint64_t>(this->a);
+            const auto b_u = static_cast<uint64_t>(this->b);
+            const auto p_u = static_cast<uint64_t>(this->p);
+            if (p_u <= (uint64_t{1} << 32)) {
+                nodeid = static_cast<NodeID>((a_u * static_cast<uint64_t>(nodeid) + b_u) % p_u);
+            } else {
+                __extension__ typedef unsigned __int128 uint128;
+                nodeid = static_cast<NodeID>((static_cast<uint128>(a_u) * static_cast<uint64_t>(nodeid) + b_u) % p_u);
+            }
+
+            // Reroll any ids from the "Overflow-Range" [size, p]
+            if (nodeid < this->size)
+                return this->offset + nodeid;
+        }
+    }
 };
 
 
 // Container for the Degree/Attribute-Distribution for a single Type of Node
 class NodeType {
     private:
-        std::unordered_map<Edgecolor, AliasTable<std::uniform_int_distribution<NodeID> > > in_distribution;
-        std::unordered_map<Edgecolor, AliasTable<std::uniform_int_distribution<NodeID> > > out_distribution;
-
-        std::mt19937 rdm_gen;
+        std::unordered_map<Edgecolor, AliasTable<IdRange> > in_distribution;
+        std::unordered_map<Edgecolor, AliasTable<IdRange> > out_distribution;
 
         std::string type_name;
         Number offset{};
@@ -118,51 +333,392 @@ class NodeType {
     public:
         NodeType(const std::string &name, Number offset, Number nodeCount,
                  std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count> > > in_degrees,
-                 std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count> > > out_degrees);
+                 std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count> > > out_degrees,
+                 uint64_t seed);
+
+        explicit NodeType(BinaryIn &in);
 
         NodeType() = default;
 
         ~NodeType() = default;
 
-        NodeID get_start_node(const Edgecolor &color);
+        NodeID get_start_node(const Edgecolor &color, CounterRng &rng) const;
+
+        NodeID get_target_node(const Edgecolor &color, CounterRng &rng) const;
 
-        NodeID get_target_node(const Edgecolor &color);
+        // Samplers for the start/target nodes of the given color. The NodeType must outlive them.
+        NodeSampler get_start_sampler(const Edgecolor &color) const;
 
-        std::string get_type_name();
+        NodeSampler get_target_sampler(const Edgecolor &color) const;
+
+        const std::string &get_type_name() const;
 
         Number get_size() const;
 
         Number get_offset() const;
+
+        void save(BinaryOut &out) const;
 };
 
 
 
 
+// A generated edge, without its color.
+struct Edge {
+    NodeID start;
+    NodeID end;
+};
+
+// Consecutive edges of a single color, as generated by one block of work.
+//      color_id is the position of the color in the (sorted) output, first the index of the first edge in the color.
+struct EdgeBatch {
+    const Edgecolor &color;
+    Index color_id;
+    Count first;
+    std::span<const Edge> edges;
+};
+
+// Layout of the generated output, passed to the writer before any edge or node.
+//      Colors are indexed by their color_id. The edges of a color are passed with first in [first, first + count),
+//      fewer edges may be passed if edges are left out (see SIMPLE_GRAPH). Types are listed by ascending IDs, the
+//      nodes of a type have the IDs [first, first + count). Only the parts of the generated shard are included.
+struct GraphSchema {
+    struct Color {
+        Edgecolor name;
+        Count first;
+        Count count;
+    };
+
+    struct Type {
+        Nodetype name;
+        NodeID first;
+        Count count;
+    };
+
+    std::vector<Color> colors;
+    std::vector<Type> types;
+
+    // IDs of all nodes of the graph, [first_node, first_node + nbr_nodes). Edges of a shard refer to all of them.
+    NodeID first_node = 0;
+    Count nbr_nodes = 0;
+};
+
+
 // Provide an interface (abstract class) to implement specific writers.
 // If you decide to implement a new writer, care should be taken to make it thread-safe.
 //      Multithreading will be used to generate the data passed to this structure!
+// The generator passes edges in batches of a few thousand edges. By default, a batch is split into single calls of
+//      writeEdge(), writers with a per-call overhead (locking, formatting, system-calls) should override writeEdges().
 class GraphWriter {
 public:
     virtual ~GraphWriter();
 
+    // Called once before any node or edge is passed, e.g. to preallocate the output.
+    virtual void begin(const GraphSchema &schema);
+
+    // Whether the batches of a color have to be passed in the order of their positions. Writers placing the batches
+    //      by their position themselves accept them in any order, concurrently from all generating threads.
+    virtual bool ordered() const;
+
+    virtual void writeEdges(const EdgeBatch &batch);
     virtual void writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode);
     virtual void writeNode(const Nodetype &nodeType, NodeID node);
 
-protected:
-    std::ofstream node_file;
-    std::ofstream edge_file;
+    // Write the nodes [first, last) of a type. By default, every node is passed to writeNode(), writers should
+    //      override this to format the whole range at once (the generator writes all nodes this way).
+    virtual void writeNodeRange(const Nodetype &nodeType, NodeID first, NodeID last);
+
+    // Called once after all nodes and edges have been passed, e.g. to write buffered data.
+    virtual void finish();
+};
+
+
+// Formats of the file-writers.
+enum class OutputFormat {
+    TSV,
+    BINARY,
+};
+
+// Settings of the output-files of the writers.
+struct OutputOptions {
+    AsyncFileOptions io;
+    // Compress the output in independent blocks, e.g. into a multi-member .gz or multi-frame .zst file.
+    Compression compression = Compression::NONE;
+    int compression_level = 0;
+};
+
+
+// Output-file shared by the threads of a writer, written asynchronously (see AsyncFile.h).
+// Blocks are compressed by the calling threads, so compression runs on all cores. Once the schema is known, the
+//      blocks of edges are appended in the order of their positions, independent of the order they are passed in.
+class BlockOutput {
+public:
+    // Files may share the I/O-thread of an AsyncIO. With compression, blocks of edges smaller than min_block_size are
+    //      collected and compressed together, so many small blocks do not become many small gzip-members/zstd-frames.
+    BlockOutput(const std::string &path, const OutputOptions &options, std::shared_ptr<AsyncIO> io = nullptr,
+                size_t min_block_size = 0);
+
+    void begin(const GraphSchema &schema);
+
+    // Whether the positions of the colors are known, i.e. the blocks of edges can be passed unordered.
+    bool knows_positions() const;
+
+    // Compress the data of a block, if requested. The compressed block is kept in the storage.
+    std::string_view encode(std::string_view data, std::string &storage) const;
+
+    // Append an encoded block. The callers have to keep the order of these blocks themselves.
+    void append(std::string_view block);
+
+    // Encode the block of the edges [first, first + count) of a color and append it after all preceding blocks.
+    void append_edges(Index color_id, Count first, Count count, std::string_view data);
+
+    // Collect the data of edges, passed in the order of the file by the caller. Once the collected data reaches the
+    //      minimum block size, it is returned with its number and has to be passed to append_collected(), which
+    //      encodes it and appends it after the blocks with smaller numbers.
+    std::pair<std::string, uint64_t> collect(std::string_view data);
+    void append_collected(uint64_t sequence, std::string_view block);
+
+    void close();
+
+private:
+    AsyncFile file;
+    Compression compression;
+    int compression_level;
+
+    std::mutex mutex;
+    std::condition_variable turn;
+    // Per color_id: the position of the next block to append.
+    std::vector<Count> color_next;
+
+    // Edges collected up to the minimum block size, and the numbers of the collected and written blocks.
+    size_t min_block_size;
+    std::string collected;
+    uint64_t blocks_collected = 0;
+    uint64_t blocks_written = 0;
+
+    // Whether any data has been written to the file.
+    bool written = false;
+
+    void collect_edges(Index color_id, Count first, Count count, std::string_view data);
+    std::pair<std::string, uint64_t> collect_locked(std::string_view data);
+    void write_block(std::string_view block);
 };
 
 
 // Simple Writer for "Tab-Separated-Values"-Files (.tsv)
-// Thread safety is achieved using std::osyncstream implemented by C++20
+// Every thread formats its batches into its own buffer (std::to_chars, pre-encoded colors), so the batches are
+//      accepted unordered. The buffers are appended to the file in the order of the positions, one write per batch.
 class TSVWriter : public GraphWriter {
 public:
-    TSVWriter(const std::string &node_file_path, const std::string &edge_file_path);
+    TSVWriter(const std::string &node_file_path, const std::string &edge_file_path, const OutputOptions &options = {});
     ~TSVWriter() override;
 
+    void begin(const GraphSchema &schema) override;
+    bool ordered() const override;
+
+    void writeEdges(const EdgeBatch &batch) override;
     void writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode) override;
     void writeNode(const Nodetype &nodeType, NodeID node) override;
+    void writeNodeRange(const Nodetype &nodeType, NodeID first, NodeID last) override;
+    void finish() override;
+
+private:
+    BlockOutput node_output;
+    BlockOutput edge_output;
+
+    // Per color_id: the encoded end of a line ("\t<color>\n").
+    std::vector<std::string> color_suffix;
+};
+
+
+// Writer for the binary graph format (see BinaryGraph.h), readable with READER_TYPE=BINARY.
+// Both files are preallocated to their full size from the schema and memory-mapped. Every batch is copied to the
+//      records at its own position, so the generating threads write disjoint parts of the mapping without locking.
+//      Edges left out by the generator are compacted away by finish().
+// Compressed files are written as streams of blocks instead (see BlockOutput). The header is stored uncompressed in
+//      its own block, so its record count can be replaced in place if edges have been left out.
+class BinaryWriter : public GraphWriter {
+public:
+    BinaryWriter(const std::string &node_file_path, const std::string &edge_file_path,
+                 const OutputOptions &options = {});
+    ~BinaryWriter() override;
+
+    void begin(const GraphSchema &schema) override;
+    bool ordered() const override;
+
+    void writeEdges(const EdgeBatch &batch) override;
+    void writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode) override;
+    void writeNode(const Nodetype &nodeType, NodeID node) override;
+    void writeNodeRange(const Nodetype &nodeType, NodeID first, NodeID last) override;
+    void finish() override;
+
+private:
+    std::string node_path;
+    std::string edge_path;
+    OutputOptions options;
+
+    // Mappings of the files and the byte-offsets of their record-arrays.
+    std::unique_ptr<WritableMappedFile> node_map;
+    std::unique_ptr<WritableMappedFile> edge_map;
+    uint64_t node_offset = 0;
+    uint64_t edge_offset = 0;
+
+    // Compressed streams instead of the mappings, and the color-names of the edge-header.
+    std::unique_ptr<BlockOutput> node_output;
+    std::unique_ptr<BlockOutput> edge_output;
+    std::vector<std::string> color_names;
+
+    NodeID first_id = 0;
+    Count nbr_nodes = 0;
+    std::unordered_map<Nodetype, uint32_t> type_index;
+
+    // Per color_id: first position of the schema, first record in the file, capacity and number of written edges.
+    std::vector<Count> color_first;
+    std::vector<Count> color_base;
+    std::vector<Count> color_capacity;
+    std::unique_ptr<std::atomic<Count>[]> color_written;
+
+    Count edge_capacity() const;
+};
+
+
+// Writes the graph into several files, which can be loaded in parallel (see src/Writer.cpp).
+// Edges are split into one file per color and/or id_partitions files by ranges of their start-IDs, nodes into the
+//      same ranges of IDs. The threads split and format their batches into the parts of the files concurrently. The
+//      parts are appended in the order of the positions by whichever thread completes that order, the other threads
+//      leave their batches behind without waiting, and empty parts are never passed to a file. All files share one
+//      I/O-thread, and only the files being written are open: the files of the current color, and a node-file from
+//      its first until its last node. With compression, the parts are collected per file into blocks of at least
+//      256 KiB, which are compressed by the threads again.
+//      finish() writes a manifest ("<edge-file>.manifest.tsv") listing files and record counts.
+class PartitionedWriter : public GraphWriter {
+public:
+    PartitionedWriter(OutputFormat format, const std::string &node_file_path, const std::string &edge_file_path,
+                      bool by_color, Count id_partitions, const OutputOptions &options = {});
+    ~PartitionedWriter() override;
+
+    void begin(const GraphSchema &schema) override;
+    bool ordered() const override;
+
+    void writeEdges(const EdgeBatch &batch) override;
+    void writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode) override;
+    void writeNode(const Nodetype &nodeType, NodeID node) override;
+    void writeNodeRange(const Nodetype &nodeType, NodeID first, NodeID last) override;
+    void finish() override;
+
+    // Path of a partition: The color and/or partition are inserted before the extension(s) of the given path.
+    static std::string partition_path(const std::string &path, const std::string &color, Count partition,
+                                      Count partitions);
+
+private:
+    struct Partition {
+        std::string path;
+        // Color of the edges, empty for nodes or edges of all colors, and the range of (start-)IDs.
+        Edgecolor color;
+        NodeID first_id;
+        NodeID last_id;
+        std::unique_ptr<BlockOutput> output;
+        bool opened = false;
+        std::atomic<Count> records{0};
+    };
+
+    OutputFormat format;
+    std::string node_path;
+    std::string edge_path;
+    bool by_color;
+    Count id_partitions;
+    OutputOptions options;
+
+    // The open files share the I/O-thread and the buffers in flight, every file adds the buffer it fills.
+    OutputOptions partition_options;
+    std::shared_ptr<AsyncIO> io;
+
+    GraphSchema schema;
+    std::vector<std::string> color_suffix;
+    std::unordered_map<Edgecolor, Index> color_index;
+    std::unordered_map<Nodetype, uint32_t> type_index;
+
+    // Edge-files per [color_id (only by_color) * id_partitions + partition], node-files per partition.
+    std::vector<std::unique_ptr<Partition> > edge_partitions;
+    std::vector<std::unique_ptr<Partition> > node_partitions;
+
+    // With files per color, only the files of the current color are open. The color is checked without the mutex.
+    std::mutex open_mutex;
+    std::atomic<Index> open_color{-1};
+
+    // Formatted batches of the current color, waiting for their preceding batches. The parts of the files are
+    //      (partition, offset, length) in the data, only non-empty parts are kept.
+    struct PendingBatch {
+        Count count = 0;
+        std::string data;
+        std::vector<std::tuple<Count, size_t, size_t> > parts;
+    };
+    std::mutex pending_mutex;
+    std::map<Count, PendingBatch> pending;
+    Index pending_color = -1;
+    Count pending_next = 0;
+    bool appending = false;
+
+    NodeID partition_bound(Count partition) const;
+    Count partition_of(NodeID node) const;
+    Partition &edge_partition(Index color_id, Count partition);
+    void open_color_files(Index color_id);
+    void append_pending(std::unique_lock<std::mutex> &lock, Index color_id, bool all);
+    void open(Partition &partition, bool nodes);
+    void close(Partition &partition, bool nodes);
+};
+
+
+// Sorts the edges of every color by (start, end) before passing them to another writer (see src/SortingWriter.cpp).
+// Edges are collected up to the memory budget, sorted in parallel and spilled to a file, one sorted run per spill.
+//      The runs of a color are merged when the next color starts or at finish(), in several passes if there are many.
+//      Nodes are passed on immediately.
+class SortingWriter : public GraphWriter {
+public:
+    SortingWriter(std::unique_ptr<GraphWriter> output, size_t memory_budget_bytes, const std::string &spill_directory);
+    ~SortingWriter() override;
+
+    void begin(const GraphSchema &schema) override;
+    bool ordered() const override;
+
+    void writeEdges(const EdgeBatch &batch) override;
+    void writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode) override;
+    void writeNode(const Nodetype &nodeType, NodeID node) override;
+    void writeNodeRange(const Nodetype &nodeType, NodeID first, NodeID last) override;
+    void finish() override;
+
+private:
+    std::unique_ptr<GraphWriter> output;
+    std::mutex mutex;
+
+    // First positions of the colors, the sorted edges are passed to the output from there.
+    std::vector<Count> color_first;
+
+    Edgecolor color;
+    Index color_id = -1;
+    std::vector<Edge> buffer;
+    size_t buffer_capacity;
+
+    // A full buffer is swapped with this one and spilled without holding the mutex, while the other threads fill the
+    //      buffer. At most one spill is in flight, the memory budget covers both buffers.
+    std::vector<Edge> spilling;
+    bool spill_running = false;
+    std::condition_variable spill_done;
+
+    // Spill-file of the current color and the (offset, length) of its runs, in edges.
+    //      Only changed by the spill in flight, or while holding the mutex without a spill in flight.
+    std::string spill_directory;
+    std::string spill_path;
+    std::ofstream spill_file;
+    std::vector<std::pair<uint64_t, uint64_t> > runs;
+    uint64_t spilled = 0;
+
+    void begin_color(std::unique_lock<std::mutex> &lock, const Edgecolor &next_color, Index next_color_id);
+    void spill_buffer(std::unique_lock<std::mutex> &lock);
+    void wait_for_spill(std::unique_lock<std::mutex> &lock);
+    void spill(std::vector<Edge> &edges);
+    void reduce_runs();
+    void finish_color(std::unique_lock<std::mutex> &lock);
 };
 
 
@@ -173,8 +729,10 @@ class BenchmarkWriter : public GraphWriter {
     public:
         explicit BenchmarkWriter(unsigned int padding_bytes_per_edge = 3, unsigned int padding_bytes_per_node = 2);
 
+        void writeEdges(const EdgeBatch &batch) override;
         void writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode) override;
         void writeNode(const Nodetype &nodeType, NodeID node) override;
+        void writeNodeRange(const Nodetype &nodeType, NodeID first, NodeID last) override;
 
         void startTimer();
         float stopTimer() const;
@@ -198,22 +756,33 @@ class BenchmarkWriter : public GraphWriter {
 // Scaled up representation of the generator, derived from some model.
 class GraphModel {
 public:
-    GraphModel(InputModel m, long double scalingFactor);
+    GraphModel(InputModel &m, long double scalingFactor, uint64_t seed, long double baseScalingFactor = 0);
+
+    GraphModel(const std::string &filepath, long double scalingFactor, uint64_t seed);
 
-    GraphModel(const std::string &filepath, long double scalingFactor);
+    // Generate the whole graph, or only one of shard_count disjoint shards of it (see GraphModel.cpp).
+    void generate(GraphWriter &writer, Count shard_index = 0, Count shard_count = 1);
 
-    void generate(GraphWriter &writer);
+    void save(const std::string &filepath) const;
+
+    // Generate a simple graph: No self-loops and no multi-edges within a color (see SimpleGraph.h).
+    //      The drawn edges held at once are limited to roughly memory_budget_bytes (0: no limit).
+    void enable_simple_graph(size_t memory_budget_bytes = 0);
 
 private:
-    InputModel model;
+    long double scale{};
+    uint64_t seed{};
     Count nbr_nodes{};
     std::unordered_map<Edgecolor, Count> nbr_edges;
 
-    // Reference to NodeType-Objects
-    std::unordered_map<Nodetype, NodeType> nodes;
+    // NodeType-Objects in the order of their IDs. The transitions of the EdgeDistributions refer to these positions.
+    std::vector<NodeType> nodes;
 
     // Reference to EdgeType-Objects
     std::unordered_map<Edgecolor, EdgeDistribution> edges;
+
+    bool simple_graph = false;
+    Count simple_pass_edges = 0;
 };
 
 
@@ -0,0 +1,187 @@
+/*
+    Memory-mappings of complete files (POSIX mmap), read-only for the inputs and writable for preallocated outputs.
+    The mapping is released when the object is destroyed; views into the mapping must not outlive it.
+*/
+
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+class MappedFile {
+private:
+    void *addr = nullptr;
+    size_t length = 0;
+
+public:
+    explicit MappedFile(const std::string &filepath);
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ~MappedFile();
+
+    const char *data() const;
+    size_t size() const;
+    std::string_view view() const;
+};
+
+
+inline MappedFile::MappedFile(const std::string &filepath) {
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open file '" + filepath + "' for reading.");
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not determine the size of file '" + filepath + "'.");
+    }
+    this->length = static_cast<size_t>(st.st_size);
+
+    // Empty files cannot be mapped, they are represented by an empty view instead.
+    if (this->length > 0) {
+        this->addr = ::mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (this->addr == MAP_FAILED) {
+            this->addr = nullptr;
+            ::close(fd);
+            throw std::runtime_error("Could not memory-map file '" + filepath + "'.");
+        }
+        // The inputs are mostly scanned front to back, let the kernel read ahead aggressively.
+        ::madvise(this->addr, this->length, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+}
+
+inline MappedFile::MappedFile(MappedFile &&other) noexcept {
+    this->addr = std::exchange(other.addr, nullptr);
+    this->length = std::exchange(other.length, 0);
+}
+
+inline MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        if (this->addr != nullptr)
+            ::munmap(this->addr, this->length);
+        this->addr = std::exchange(other.addr, nullptr);
+        this->length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+inline MappedFile::~MappedFile() {
+    if (this->addr != nullptr)
+        ::munmap(this->addr, this->length);
+}
+
+inline const char *MappedFile::data() const {
+    return static_cast<const char *>(this->addr);
+}
+
+inline size_t MappedFile::size() const {
+    return this->length;
+}
+
+inline std::string_view MappedFile::view() const {
+    return {this->data(), this->length};
+}
+
+
+
+
+// Writable memory-mapping of a file of a given size (POSIX mmap), e.g. to fill the records of a file in parallel.
+// The file is created if needed and resized to the given size, keeping its content up to that size (e.g. a header
+// written before). Changes are written back by the kernel, like any other buffered write.
+class WritableMappedFile {
+private:
+    int fd = -1;
+    void *addr = nullptr;
+    size_t length = 0;
+    std::string path;
+
+    void map();
+
+public:
+    WritableMappedFile(const std::string &filepath, size_t size);
+
+    WritableMappedFile(const WritableMappedFile &) = delete;
+    WritableMappedFile &operator=(const WritableMappedFile &) = delete;
+
+    ~WritableMappedFile();
+
+    char *data() const;
+    size_t size() const;
+
+    // Change the size of the file, e.g. to cut off unused space. Pointers into the previous mapping become invalid.
+    void resize(size_t size);
+
+    // Release the mapping, the changes are written back by the kernel.
+    void close();
+};
+
+
+inline WritableMappedFile::WritableMappedFile(const std::string &filepath, const size_t size) : path(filepath) {
+    this->fd = ::open(filepath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (this->fd < 0)
+        throw std::runtime_error("Could not open file '" + filepath + "' for writing.");
+    this->resize(size);
+}
+
+inline void WritableMappedFile::map() {
+    if (this->length == 0) { return; }
+    this->addr = ::mmap(nullptr, this->length, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (this->addr == MAP_FAILED) {
+        this->addr = nullptr;
+        throw std::runtime_error("Could not memory-map file '" + this->path + "' for writing.");
+    }
+}
+
+inline void WritableMappedFile::resize(const size_t size) {
+    if (this->addr != nullptr)
+        ::munmap(this->addr, this->length);
+    this->addr = nullptr;
+    // The space is allocated up front, running out of disk space while writing to the mapping would be fatal.
+    if (::ftruncate(this->fd, static_cast<off_t>(size)) != 0
+        || (size > this->length && ::posix_fallocate(this->fd, 0, static_cast<off_t>(size)) != 0))
+        throw std::runtime_error("Could not resize file '" + this->path + "' to " + std::to_string(size)
+                                 + " bytes. Is the disk full?");
+    this->length = size;
+    this->map();
+}
+
+inline void WritableMappedFile::close() {
+    if (this->addr != nullptr) {
+        ::munmap(this->addr, this->length);
+        this->addr = nullptr;
+    }
+    if (this->fd >= 0) {
+        ::close(this->fd);
+        this->fd = -1;
+    }
+}
+
+inline WritableMappedFile::~WritableMappedFile() {
+    if (this->addr != nullptr)
+        ::munmap(this->addr, this->length);
+    if (this->fd >= 0)
+        ::close(this->fd);
+}
+
+inline char *WritableMappedFile::data() const {
+    return static_cast<char *>(this->addr);
+}
+
+inline size_t WritableMappedFile::size() const {
+    return this->length;
+}
@@ -0,0 +1,103 @@
+/*
+    Counter-based random numbers for the parallel generation.
+
+    Every random stream is identified by a 64-bit key, derived from the RNG-Seed and the position of the stream
+    in the output (e.g. Edge-Color and block of edges). The n-th number of a stream is a pure function of key and n,
+    so the generated graph only depends on the seed and not on the number of threads or the order of their work.
+    The streams use the SplitMix64-generator [1], unbiased bounded numbers use the method of D. Lemire [2].
+
+    [1] G.L. Steele, D. Lea, C.H. Flood, "Fast Splittable Pseudorandom Number Generators"
+        In OOPSLA '14, pp. 453-472, 2014
+        DOI: 10.1145/2660193.2660195
+
+    [2] D. Lemire, "Fast Random Integer Generation in an Interval"
+        In ACM Transactions on Modeling and Computer Simulation, Vol. 29, No. 1, 2019
+        DOI: 10.1145/3230636
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+
+// Increment of the SplitMix64-generator (2^64 / golden ratio)
+constexpr uint64_t RNG_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+
+// SplitMix64-finalizer: A bijective mixing of all bits of x.
+constexpr uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+// Stable hash of a name (FNV-1a). Unlike std::hash, the value is the same for every platform and standard library.
+constexpr uint64_t hash_name(const std::string_view name) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const char c : name)
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    return h;
+}
+
+
+// Key of an independent sub-stream, e.g. derive_key(derive_key(seed, color), block).
+constexpr uint64_t derive_key(const uint64_t key, const uint64_t component) {
+    return mix64(key ^ mix64(component + RNG_GAMMA));
+}
+
+
+// A single random stream. Cheap to create, so every block of work uses its own instance.
+// Satisfies UniformRandomBitGenerator, so it can be used with the distributions of <random> as well.
+class CounterRng {
+public:
+    using result_type = uint64_t;
+
+    explicit CounterRng(const uint64_t key) : key(key) {}
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        return mix64(this->key + (++this->counter) * RNG_GAMMA);
+    }
+
+    // Uniformly distributed double in [0, 1), using the upper 53 bits.
+    double uniform() {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Integer in [0, n) by a single multiply-shift. The bias of at most n/2^64 is negligible, in exchange the draw
+    //      needs no branch and can be reproduced exactly by vectorized code (see AliasTable::fill()).
+    uint64_t scaled(const uint64_t n) {
+        __extension__ typedef unsigned __int128 uint128;
+        return static_cast<uint64_t>((static_cast<uint128>((*this)()) * n) >> 64);
+    }
+
+    // Uniformly distributed integer in [0, n) for n > 0, without modulo-bias.
+    uint64_t below(const uint64_t n) {
+        __extension__ typedef unsigned __int128 uint128;
+        uint128 m = static_cast<uint128>((*this)()) * n;
+        if (static_cast<uint64_t>(m) < n) {
+            const uint64_t threshold = (0 - n) % n;
+            while (static_cast<uint64_t>(m) < threshold)
+                m = static_cast<uint128>((*this)()) * n;
+        }
+        return static_cast<uint64_t>(m >> 64);
+    }
+
+    // The next number is mix64(key + (counter + 1) * RNG_GAMMA). Used by vectorized code to compute many numbers at once.
+    uint64_t get_key() const { return this->key; }
+
+    uint64_t get_counter() const { return this->counter; }
+
+    void skip(const uint64_t n) { this->counter += n; }
+
+private:
+    uint64_t key;
+    uint64_t counter = 0;
+};
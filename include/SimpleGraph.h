@@ -0,0 +1,54 @@
+/*
+    Simple-graph mode: Removes self-loops and multi-edges from the generated edges of a color.
+
+    A color is split into buckets by the hash of the start-nodes of its edges. A rejected edge keeps its start-node and
+    only gets a new end-node, so all copies of an edge and all of their replacements stay in the same bucket. The
+    buckets of a color are therefore made simple independently of each other, and a shard or pass of the generator only
+    holds the buckets it writes (see GraphModel::generate()).
+
+    Within a bucket, the edges are distributed to partitions by their hash. Every partition keeps its own hash-set of
+    the accepted edges and is checked by a single thread, so the partitions need no synchronization. Within a
+    partition, the edges are checked in order of their positions, i.e. the first occurrence of an edge is kept and
+    every later occurrence is rejected. Rejected edges are drawn again in rounds, every position from its own random
+    stream per round. The result is therefore independent of the number of threads, partitions, passes and shards.
+*/
+
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "GraphGenTypes.h"
+
+
+// Number of rejected draws while making the edges of a color simple.
+struct SimpleGraphStats {
+    Count self_loops = 0;
+    Count duplicates = 0;
+    // Edges without a valid replacement after the last round. They are set to NO_EDGE.
+    Count dropped = 0;
+};
+
+// Placeholder for a dropped edge.
+constexpr Edge NO_EDGE{-1, -1};
+
+
+// Expected number of edges in a bucket of a color.
+constexpr Count SIMPLE_BUCKET_EDGES = Count{1} << 20;
+
+// Memory per drawn edge kept by a pass of the generator, until its bucket is made simple.
+constexpr size_t SIMPLE_PASS_BYTES_PER_EDGE = 48;
+
+// Number of buckets of a color with the given number of edges, at least one.
+Count simple_buckets(Count edges);
+
+// Bucket of an edge with the given start-node.
+Count simple_bucket(NodeID start, Count buckets);
+
+
+// Remove all self-loops and duplicates from the given edges of a bucket. Rejected edges keep their start-node, the
+//      new end-node of the edge at a position is drawn by draw_end(position, rng), from streams derived from the key,
+//      the round and the position. Needs about 64 bytes per edge for the partitions.
+SimpleGraphStats make_simple(std::vector<Edge> &edges, uint64_t key,
+                             const std::function<NodeID(Count, CounterRng &)> &draw_end);
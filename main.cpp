@@ -2,27 +2,14 @@
 #include <ConfigParser.h>
 
 
-int main(int argc, char *argv[]){
-    // Enforce passing precisely one argument.
-    if (argc != 2) {
-        throw std::invalid_argument("Expected 1 argument (filepath to configuration) but got " + std::to_string(argc-1));
-    }
-
-    // Try to parse the config file.
-    Config cfg = readConfig(argv[1]);
-
-    // RNG-Seed-Initialization
-    // TODO: Consider the effect of initializing all rdm_sources from the same seed.
-    // TODO:    There might be some nasty correlation hidden here - a possible fix would be to advance the seed once
-    // TODO:    before the next initialization.
-    if (cfg.rng_seed == 0)
-        cfg.rng_seed = std::time(nullptr);
-    std::srand(cfg.rng_seed);
-    std::cout << "[INFO] Initialized randomness with seed '" << cfg.rng_seed << "'" << std::endl;
-
-
+// Read and preprocess the input, then scale it to the model of the generator.
+static GraphModel build_model(const Config &cfg) {
     std::cout << "[1/4] Initializing..." << std::endl;
     InputModel in_model = InputModel();
+    if (cfg.ingest_memory_budget > 0) {
+        std::cout << "\tApproximate ingestion within " << cfg.ingest_memory_budget << " MiB." << std::endl;
+        in_model.enable_sampling(cfg.ingest_memory_budget * 1024 * 1024);
+    }
 
     std::cout << "[2/4] Reading Data..." << std::endl;
     switch (cfg.reader_type) {
@@ -31,32 +18,148 @@ int main(int argc, char *argv[]){
             tsv_reader.readTo(in_model);
             break;
         }
+        case(INPUT_TYPE::I_TSV_PARALLEL): {
+            auto tsv_reader = ParallelTSVReader(cfg.node_files, cfg.edge_files);
+            tsv_reader.readTo(in_model);
+            break;
+        }
+        case(INPUT_TYPE::I_BINARY): {
+            auto binary_reader = BinaryReader(cfg.node_files, cfg.edge_files);
+            binary_reader.readTo(in_model);
+            break;
+        }
+        case(INPUT_TYPE::I_SNAPSHOT): {
+            std::cout << "\tLoading model-snapshot \"" << cfg.model_snapshot << "\"..." << std::endl;
+            in_model = InputModel(cfg.model_snapshot);
+            break;
+        }
+        case(INPUT_TYPE::I_COMPILED):
         case(INPUT_TYPE::I_EMPTY):
             throw std::invalid_argument("The reader-type was not recognized. Fix the validation in your config!");
     }
 
     std::cout << "[3/4] Preprocessing..." << std::endl;
     in_model.preprocess();
+    if (cfg.reader_type != INPUT_TYPE::I_SNAPSHOT && !cfg.model_snapshot.empty()) {
+        std::cout << "\tSaving model-snapshot to \"" << cfg.model_snapshot << "\"..." << std::endl;
+        in_model.save(cfg.model_snapshot);
+    }
+
+    if (cfg.base_scalingFactor > 0) {
+        std::cout << "\tOnly the nodes/edges extending a graph of the scaling-factor " << cfg.base_scalingFactor
+                  << " are generated." << std::endl;
+        std::cerr << "[WARNING] The new edges only connect new nodes, the extended graph is the disjoint union of the "
+                     "base-graph and the new nodes, not a graph of the scaling-factor " << cfg.scalingFactor << "."
+                  << std::endl;
+    }
+    GraphModel graph = GraphModel(in_model, cfg.scalingFactor, cfg.rng_seed, cfg.base_scalingFactor);
+    if (!cfg.compiled_model.empty()) {
+        std::cout << "\tSaving compiled model to \"" << cfg.compiled_model << "\"..." << std::endl;
+        graph.save(cfg.compiled_model);
+    }
+    return graph;
+}
+
+
+// Map a previously compiled model, all reading and preprocessing is skipped.
+static GraphModel load_compiled_model(const Config &cfg) {
+    std::cout << "[1/4] Initializing..." << std::endl;
+    std::cout << "[2/4] Reading Data..." << std::endl;
+    std::cout << "\tLoading compiled model \"" << cfg.compiled_model << "\"..." << std::endl;
+    GraphModel graph = GraphModel(cfg.compiled_model, cfg.scalingFactor, cfg.rng_seed);
+    std::cout << "[3/4] Preprocessing..." << std::endl;
+    return graph;
+}
+
+
+int main(int argc, char *argv[]){
+    // Enforce passing the configuration, optionally followed by "--shard i/N".
+    if (argc != 2 && !(argc == 4 && std::string(argv[2]) == "--shard")) {
+        throw std::invalid_argument("Expected 1 argument (filepath to configuration), optionally followed by "
+                                    "'--shard INDEX/COUNT', but got " + std::to_string(argc-1));
+    }
+
+    // Try to parse the config file.
+    Config cfg = readConfig(argv[1]);
+    if (argc == 4)
+        parse_shard(argv[3], cfg);
+    if (cfg.shard_count > 1)
+        std::cout << "[INFO] Generating shard " << cfg.shard_index << " of " << cfg.shard_count << "." << std::endl;
+
+    // RNG-Seed-Initialization
+    // Every random stream of the generator is derived from this seed (see Random.h), so the output is reproducible.
+    if (cfg.rng_seed == 0)
+        cfg.rng_seed = std::time(nullptr);
+    std::cout << "[INFO] Initialized randomness with seed '" << cfg.rng_seed << "'" << std::endl;
+
+
+    GraphModel graph = (cfg.reader_type == INPUT_TYPE::I_COMPILED) ? load_compiled_model(cfg) : build_model(cfg);
+
+    if (cfg.simple_graph) {
+        if (cfg.simple_graph_memory_budget > 0)
+            std::cout << "\tMaking the graph simple within " << cfg.simple_graph_memory_budget << " MiB." << std::endl;
+        graph.enable_simple_graph(cfg.simple_graph_memory_budget * 1024 * 1024);
+    }
 
     std::cout << "[4/4] Generating..." << std::endl;
-    GraphModel graph = GraphModel(in_model, cfg.scalingFactor);
+    const OutputOptions output_options{{cfg.output_buffer_size * 1024, cfg.output_queue_depth, cfg.output_direct_io},
+                                       cfg.output_compression, cfg.output_compression_level};
+    if (cfg.output_compression != Compression::NONE)
+        std::cout << "\tCompressing the output with " << compression_name(cfg.output_compression) << "." << std::endl;
 
+    const bool partitioned = cfg.output_partition_by_color || cfg.output_partitions > 1;
+    if (partitioned && cfg.writer_type != OUTPUT_TYPE::O_BENCHMARK)
+        std::cout << "\tPartitioning the output into " << cfg.output_partitions << " ID-range(s)"
+                  << (cfg.output_partition_by_color ? " per edge color" : "") << ", see the manifest next to the edges."
+                  << std::endl;
+
+    std::unique_ptr<GraphWriter> writer;
+    BenchmarkWriter *bench_writer = nullptr;
     switch (cfg.writer_type) {
         case(OUTPUT_TYPE::O_TSV): {
-            auto tsv_writer = TSVWriter(cfg.output_file_nodes, cfg.output_file_edges);
-            graph.generate(tsv_writer);
+            if (partitioned) {
+                writer = std::make_unique<PartitionedWriter>(OutputFormat::TSV, cfg.output_file_nodes,
+                                                             cfg.output_file_edges, cfg.output_partition_by_color,
+                                                             cfg.output_partitions, output_options);
+                break;
+            }
+            writer = std::make_unique<TSVWriter>(cfg.output_file_nodes, cfg.output_file_edges, output_options);
+            break;
+        }
+        case(OUTPUT_TYPE::O_BINARY): {
+            if (partitioned) {
+                writer = std::make_unique<PartitionedWriter>(OutputFormat::BINARY, cfg.output_file_nodes,
+                                                             cfg.output_file_edges, cfg.output_partition_by_color,
+                                                             cfg.output_partitions, output_options);
+                break;
+            }
+            writer = std::make_unique<BinaryWriter>(cfg.output_file_nodes, cfg.output_file_edges, output_options);
             break;
         }
         case(OUTPUT_TYPE::O_BENCHMARK): {
-            auto bench_writer = BenchmarkWriter(0, 0);
-            bench_writer.startTimer();
-            graph.generate(bench_writer);
-            bench_writer.info(bench_writer.stopTimer());
+            auto benchmark = std::make_unique<BenchmarkWriter>(0, 0);
+            bench_writer = benchmark.get();
+            writer = std::move(benchmark);
             break;
         }
         case(OUTPUT_TYPE::O_EMPTY):
             throw std::invalid_argument("The reader-type was not recognized. Fix the validation in your config!");
     }
 
+    if (cfg.sort_output) {
+        std::cout << "\tSorting the edges of every color within " << cfg.sort_memory_budget << " MiB." << std::endl;
+        if (cfg.shard_count > 1)
+            std::cerr << "[WARNING] Only the edges of this shard are sorted, the concatenated shards are not sorted."
+                      << std::endl;
+        writer = std::make_unique<SortingWriter>(std::move(writer), cfg.sort_memory_budget * 1024 * 1024,
+                                                 cfg.sort_directory);
+    }
+
+    if (bench_writer)
+        bench_writer->startTimer();
+    graph.generate(*writer, cfg.shard_index, cfg.shard_count);
+    if (bench_writer)
+        bench_writer->info(bench_writer->stopTimer());
+
     std::cout << "Done!" << std::endl;
 }
\ No newline at end of file
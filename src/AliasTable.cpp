@@ -0,0 +1,202 @@
+/*
+    Vectorized batch-sampling from alias-tables (see AliasTable::fill()).
+
+    Every draw consumes two numbers of the CounterRng: One for the slot, one for the comparison with its threshold.
+    As the numbers of a CounterRng are a pure function of its key and counter, the vectorized kernels compute the
+    numbers of 4 (AVX2) or 8 (AVX-512) draws at once and produce exactly the same indices as the scalar kernel.
+*/
+
+
+#include "AliasTable.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    #define GRAPHGEN_X86_KERNELS
+    #include <immintrin.h>
+#endif
+
+
+static void fill_scalar(const std::span<const probability> thresholds, const std::span<const AliasIndex> aliases,
+                        CounterRng &rng, const std::span<AliasIndex> out) {
+    for (AliasIndex &idx : out)
+        idx = alias_draw(thresholds, aliases, rng);
+}
+
+
+#ifdef GRAPHGEN_X86_KERNELS
+
+// AVX2 has no 64-bit multiplication, it is composed of three 32x32->64-bit multiplications.
+__attribute__((target("avx2")))
+static inline __m256i mullo64_avx2(const __m256i a, const __m256i b) {
+    const __m256i lo = _mm256_mul_epu32(a, b);
+    const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                           _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mix64_avx2(__m256i x) {
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 30));
+    x = mullo64_avx2(x, _mm256_set1_epi64x(static_cast<long long>(0xbf58476d1ce4e5b9ULL)));
+    x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 27));
+    x = mullo64_avx2(x, _mm256_set1_epi64x(static_cast<long long>(0x94d049bb133111ebULL)));
+    return _mm256_xor_si256(x, _mm256_srli_epi64(x, 31));
+}
+
+// Upper 64 bits of r * n for n < 2^32, i.e. CounterRng::scaled().
+__attribute__((target("avx2")))
+static inline __m256i scaled_avx2(const __m256i r, const __m256i n) {
+    const __m256i lo = _mm256_mul_epu32(r, n);
+    const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(r, 32), n);
+    return _mm256_srli_epi64(_mm256_add_epi64(hi, _mm256_srli_epi64(lo, 32)), 32);
+}
+
+// (r >> 11) * 2^-53, i.e. CounterRng::uniform(). Both 32-bit halves are converted exactly with the 2^52-trick.
+__attribute__((target("avx2")))
+static inline __m256d uniform_avx2(const __m256i r) {
+    const __m256i x = _mm256_srli_epi64(r, 11);
+    const __m256i magic = _mm256_set1_epi64x(0x4330000000000000LL);
+    const __m256d two52 = _mm256_set1_pd(0x1.0p52);
+    const __m256d lo = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(x, _mm256_set1_epi64x(0xffffffffLL)), magic)), two52);
+    const __m256d hi = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(x, 32), magic)), two52);
+    return _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(hi, _mm256_set1_pd(0x1.0p32)), lo), _mm256_set1_pd(0x1.0p-53));
+}
+
+__attribute__((target("avx2")))
+static void fill_avx2(const std::span<const probability> thresholds, const std::span<const AliasIndex> aliases,
+                      CounterRng &rng, const std::span<AliasIndex> out) {
+    const uint64_t key = rng.get_key();
+    const uint64_t counter = rng.get_counter();
+
+    // Draw i uses the numbers counter + 2i + 1 (slot) and counter + 2i + 2 (threshold).
+    __m256i state = _mm256_set_epi64x(
+        static_cast<long long>(key + (counter + 7) * RNG_GAMMA), static_cast<long long>(key + (counter + 5) * RNG_GAMMA),
+        static_cast<long long>(key + (counter + 3) * RNG_GAMMA), static_cast<long long>(key + (counter + 1) * RNG_GAMMA));
+    const __m256i gamma = _mm256_set1_epi64x(static_cast<long long>(RNG_GAMMA));
+    const __m256i step = _mm256_set1_epi64x(static_cast<long long>(8 * RNG_GAMMA));
+    const __m256i n = _mm256_set1_epi64x(static_cast<long long>(thresholds.size()));
+    const __m256i even_lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const auto *alias_base = reinterpret_cast<const int *>(aliases.data());
+
+    size_t i = 0;
+    for (; i + 4 <= out.size(); i += 4) {
+        const __m256i slot = scaled_avx2(mix64_avx2(state), n);
+        const __m256d r_bias = uniform_avx2(mix64_avx2(_mm256_add_epi64(state, gamma)));
+        state = _mm256_add_epi64(state, step);
+
+        const __m256d threshold = _mm256_i64gather_pd(thresholds.data(), slot, 8);
+        const __m128i alias = _mm256_i64gather_epi32(alias_base, slot, 4);
+        const __m256i keep = _mm256_castpd_si256(_mm256_cmp_pd(r_bias, threshold, _CMP_LT_OQ));
+
+        const __m128i slot32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(slot, even_lanes));
+        const __m128i keep32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(keep, even_lanes));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out.data() + i), _mm_blendv_epi8(alias, slot32, keep32));
+    }
+
+    rng.skip(2 * i);
+    fill_scalar(thresholds, aliases, rng, out.subspan(i));
+}
+
+
+// The AVX-512 intrinsics of GCC 12 start from deliberately undefined registers, which -Wmaybe-uninitialized reports.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f,avx512dq")))
+static inline __m512i mix64_avx512(__m512i x) {
+    x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 30));
+    x = _mm512_mullo_epi64(x, _mm512_set1_epi64(static_cast<long long>(0xbf58476d1ce4e5b9ULL)));
+    x = _mm512_xor_si512(x, _mm512_srli_epi64(x, 27));
+    x = _mm512_mullo_epi64(x, _mm512_set1_epi64(static_cast<long long>(0x94d049bb133111ebULL)));
+    return _mm512_xor_si512(x, _mm512_srli_epi64(x, 31));
+}
+
+__attribute__((target("avx512f,avx512dq")))
+static void fill_avx512(const std::span<const probability> thresholds, const std::span<const AliasIndex> aliases,
+                        CounterRng &rng, const std::span<AliasIndex> out) {
+    const uint64_t key = rng.get_key();
+    const uint64_t counter = rng.get_counter();
+
+    // Draw i uses the numbers counter + 2i + 1 (slot) and counter + 2i + 2 (threshold).
+    const __m512i lanes = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+    const __m512i gamma = _mm512_set1_epi64(static_cast<long long>(RNG_GAMMA));
+    __m512i state = _mm512_add_epi64(_mm512_set1_epi64(static_cast<long long>(key + counter * RNG_GAMMA)),
+                                     _mm512_mullo_epi64(lanes, gamma));
+    const __m512i step = _mm512_set1_epi64(static_cast<long long>(16 * RNG_GAMMA));
+    const __m512i n = _mm512_set1_epi64(static_cast<long long>(thresholds.size()));
+
+    size_t i = 0;
+    for (; i + 8 <= out.size(); i += 8) {
+        const __m512i r_slot = mix64_avx512(state);
+        const __m512i lo = _mm512_mul_epu32(r_slot, n);
+        const __m512i hi = _mm512_mul_epu32(_mm512_srli_epi64(r_slot, 32), n);
+        const __m512i slot = _mm512_srli_epi64(_mm512_add_epi64(hi, _mm512_srli_epi64(lo, 32)), 32);
+
+        const __m512i r = _mm512_srli_epi64(mix64_avx512(_mm512_add_epi64(state, gamma)), 11);
+        const __m512d r_bias = _mm512_mul_pd(_mm512_cvtepu64_pd(r), _mm512_set1_pd(0x1.0p-53));
+        state = _mm512_add_epi64(state, step);
+
+        const __m512d threshold = _mm512_i64gather_pd(slot, thresholds.data(), 8);
+        const __m512i alias = _mm512_cvtepu32_epi64(_mm512_i64gather_epi32(slot, aliases.data(), 4));
+        const __mmask8 keep = _mm512_cmp_pd_mask(r_bias, threshold, _CMP_LT_OQ);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.data() + i),
+                            _mm512_cvtepi64_epi32(_mm512_mask_blend_epi64(keep, alias, slot)));
+    }
+
+    rng.skip(2 * i);
+    fill_scalar(thresholds, aliases, rng, out.subspan(i));
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+
+
+
+bool alias_kernel_supported(const AliasKernel kernel) {
+    switch (kernel) {
+        case AliasKernel::SCALAR:
+            return true;
+#ifdef GRAPHGEN_X86_KERNELS
+        case AliasKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case AliasKernel::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+#else
+        case AliasKernel::AVX2:
+        case AliasKernel::AVX512:
+            return false;
+#endif
+    }
+    return false;
+}
+
+
+AliasKernel alias_kernel() {
+    if (alias_kernel_supported(AliasKernel::AVX512))
+        return AliasKernel::AVX512;
+    if (alias_kernel_supported(AliasKernel::AVX2))
+        return AliasKernel::AVX2;
+    return AliasKernel::SCALAR;
+}
+
+
+void alias_fill(const AliasKernel kernel, const std::span<const probability> thresholds,
+                const std::span<const AliasIndex> aliases, CounterRng &rng, const std::span<AliasIndex> out) {
+    switch (kernel) {
+#ifdef GRAPHGEN_X86_KERNELS
+        case AliasKernel::AVX512:
+            return fill_avx512(thresholds, aliases, rng, out);
+        case AliasKernel::AVX2:
+            return fill_avx2(thresholds, aliases, rng, out);
+#else
+        case AliasKernel::AVX512:
+        case AliasKernel::AVX2:
+#endif
+        case AliasKernel::SCALAR:
+            break;
+    }
+    fill_scalar(thresholds, aliases, rng, out);
+}
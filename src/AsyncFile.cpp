@@ -0,0 +1,313 @@
+#include "../include/AsyncFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef GRAPHGEN_HAVE_URING
+    #include <liburing.h>
+#endif
+
+
+// Alignment of buffers, offsets and lengths required by O_DIRECT.
+constexpr size_t DIRECT_BLOCK_SIZE = 4096;
+
+
+static size_t round_up(const size_t value, const size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+
+// One of the queue_depth buffers is the buffer being filled, which every file adds to the pool itself.
+AsyncIO::AsyncIO(const AsyncFileOptions &options)
+    : buffer_size(round_up(std::max<size_t>(options.buffer_size, 1), DIRECT_BLOCK_SIZE)),
+      queue_depth(std::max<size_t>(options.queue_depth, 2) - 1) {
+    try {
+        for (size_t i = 0; i < this->queue_depth; ++i)
+            this->add_buffer();
+    } catch (const std::bad_alloc &) {
+        for (char *buffer : this->buffers)
+            std::free(buffer);
+        throw;
+    }
+    this->io_thread = std::thread(&AsyncIO::run, this);
+}
+
+AsyncIO::~AsyncIO() {
+    {
+        std::lock_guard lock(this->mutex);
+        this->closing = true;
+    }
+    this->changed.notify_all();
+    this->io_thread.join();
+    for (char *buffer : this->buffers)
+        std::free(buffer);
+}
+
+
+// Grow the pool by one buffer. Called with the mutex held, or before the I/O-thread is started.
+void AsyncIO::add_buffer() {
+    this->buffers.reserve(this->buffers.size() + 1);
+    this->free_buffers.reserve(this->buffers.size() + 1);
+    auto *buffer = static_cast<char *>(std::aligned_alloc(DIRECT_BLOCK_SIZE, this->buffer_size));
+    if (buffer == nullptr)
+        throw std::bad_alloc();
+    this->buffers.push_back(buffer);
+    this->free_buffers.push_back(buffer);
+}
+
+// Shrink the pool by one buffer, waiting for the I/O-thread if all buffers are in use.
+void AsyncIO::remove_buffer(std::unique_lock<std::mutex> &lock) {
+    this->changed.wait(lock, [this] { return !this->free_buffers.empty(); });
+    char *buffer = this->free_buffers.back();
+    this->free_buffers.pop_back();
+    this->buffers.erase(std::find(this->buffers.begin(), this->buffers.end(), buffer));
+    std::free(buffer);
+}
+
+// The next free buffer, waiting for the I/O-thread if all buffers are queued.
+char *AsyncIO::acquire() {
+    std::unique_lock lock(this->mutex);
+    this->changed.wait(lock, [this] { return !this->free_buffers.empty() || !this->error.empty(); });
+    if (!this->error.empty())
+        throw std::runtime_error(this->error);
+    char *buffer = this->free_buffers.back();
+    this->free_buffers.pop_back();
+    return buffer;
+}
+
+void AsyncIO::submit(const Request &request) {
+    {
+        std::lock_guard lock(this->mutex);
+        if (!this->error.empty())
+            throw std::runtime_error(this->error);
+        this->queue.push_back(request);
+        ++request.file->pending;
+    }
+    this->changed.notify_all();
+}
+
+
+
+
+AsyncFile::AsyncFile(const std::string &filepath, const AsyncFileOptions &options, std::shared_ptr<AsyncIO> io)
+    : io(io ? std::move(io) : std::make_shared<AsyncIO>(options)), path(filepath), direct(options.direct) {
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (this->direct) {
+        this->fd = ::open(filepath.c_str(), flags | O_DIRECT, 0644);
+        if (this->fd < 0 && errno == EINVAL) {
+            std::cerr << "[WARNING] The file-system of '" << filepath << "' does not support O_DIRECT, "
+                      << "it is written through the page-cache." << std::endl;
+            this->direct = false;
+        }
+    }
+    if (this->fd < 0)
+        this->fd = ::open(filepath.c_str(), flags, 0644);
+    if (this->fd < 0)
+        throw std::runtime_error("Could not open '" + filepath + "' for writing.");
+
+    try {
+        {
+            std::lock_guard lock(this->io->mutex);
+            this->io->add_buffer();
+        }
+        this->current = this->io->acquire();
+    } catch (...) {
+        ::close(this->fd);
+        this->fd = -1;
+        throw;
+    }
+}
+
+AsyncFile::~AsyncFile() {
+    // Like a std::ofstream, remaining data is still written without close(), but errors are lost.
+    try {
+        this->close();
+    } catch (const std::exception &) {}
+}
+
+
+void AsyncFile::write(const char *data, size_t length) {
+    const size_t buffer_size = this->io->buffer_size;
+    while (length > 0) {
+        const size_t n = std::min(length, buffer_size - this->fill);
+        std::memcpy(this->current + this->fill, data, n);
+        this->fill += n;
+        data += n;
+        length -= n;
+        if (this->fill == buffer_size) {
+            this->submit(this->fill);
+            this->current = this->io->acquire();
+            this->fill = 0;
+        }
+    }
+}
+
+void AsyncFile::close() {
+    if (this->fd < 0) { return; }
+
+    // O_DIRECT only writes whole blocks, the padding of the last buffer is cut off again.
+    const uint64_t size = this->offset + this->fill;
+    size_t length = this->fill;
+    if (this->direct && this->current != nullptr) {
+        length = round_up(this->fill, DIRECT_BLOCK_SIZE);
+        std::memset(this->current + this->fill, 0, length - this->fill);
+    }
+    std::string failure;
+    try {
+        if (length > 0 && this->current != nullptr)
+            this->submit(length);
+    } catch (const std::runtime_error &e) {
+        failure = e.what();
+    }
+    this->fill = 0;
+
+    // Wait for the writes of this file, then return its buffer to the pool.
+    {
+        std::unique_lock lock(this->io->mutex);
+        this->io->changed.wait(lock, [this] { return this->pending == 0; });
+        if (this->current != nullptr)
+            this->io->free_buffers.push_back(this->current);
+        this->current = nullptr;
+        this->io->remove_buffer(lock);
+        if (failure.empty())
+            failure = this->io->error;
+    }
+    this->io->changed.notify_all();
+
+    if (this->direct && ::ftruncate(this->fd, static_cast<off_t>(size)) != 0 && failure.empty())
+        failure = "Could not truncate '" + this->path + "' to its size: " + std::strerror(errno);
+    if (::close(this->fd) != 0 && failure.empty())
+        failure = "Could not close '" + this->path + "': " + std::strerror(errno);
+    this->fd = -1;
+    if (!failure.empty())
+        throw std::runtime_error(failure);
+}
+
+
+// Queue the current buffer for writing.
+void AsyncFile::submit(const size_t length) {
+    this->io->submit(AsyncIO::Request{this, this->current, length, this->offset});
+    this->current = nullptr;
+    this->offset += length;
+}
+
+
+
+
+void AsyncIO::run() {
+#ifdef GRAPHGEN_HAVE_URING
+    this->run_uring();
+#else
+    this->run_pwrite();
+#endif
+}
+
+// Write the rest of a request synchronously. Returns the number of bytes written or -errno.
+static long write_fully(const int fd, const char *data, const size_t length, const uint64_t offset, size_t done) {
+    while (done < length) {
+        const ssize_t n = ::pwrite(fd, data + done, length - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return n < 0 ? -errno : -EIO; }
+        done += static_cast<size_t>(n);
+    }
+    return static_cast<long>(done);
+}
+
+void AsyncIO::run_pwrite() {
+    for (;;) {
+        Request request{};
+        {
+            std::unique_lock lock(this->mutex);
+            this->changed.wait(lock, [this] { return !this->queue.empty() || this->closing; });
+            if (this->queue.empty()) { return; }
+            request = this->queue.front();
+            this->queue.pop_front();
+        }
+        this->complete(request, write_fully(request.file->fd, request.buffer, request.length, request.offset, 0));
+    }
+}
+
+void AsyncIO::run_uring() {
+#ifdef GRAPHGEN_HAVE_URING
+    const size_t depth = this->queue_depth;
+    io_uring ring{};
+    if (io_uring_queue_init(static_cast<unsigned>(depth), &ring, 0) < 0) {
+        // e.g. disabled by the kernel or a seccomp-profile.
+        this->run_pwrite();
+        return;
+    }
+
+    // Requests in flight by their slot, a slot is free if its length is 0.
+    std::vector<Request> in_flight(depth);
+    size_t running = 0;
+    for (;;) {
+        {
+            std::unique_lock lock(this->mutex);
+            if (running == 0) {
+                this->changed.wait(lock, [this] { return !this->queue.empty() || this->closing; });
+                if (this->queue.empty()) { break; }
+            }
+            while (!this->queue.empty() && running < depth) {
+                const Request request = this->queue.front();
+                this->queue.pop_front();
+                const auto slot = static_cast<size_t>(
+                    std::find_if(in_flight.begin(), in_flight.end(), [](const Request &r) { return r.length == 0; })
+                    - in_flight.begin());
+                io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+                io_uring_prep_write(sqe, request.file->fd, request.buffer, static_cast<unsigned>(request.length),
+                                    request.offset);
+                sqe->user_data = slot;
+                in_flight[slot] = request;
+                ++running;
+            }
+        }
+        io_uring_submit(&ring);
+
+        io_uring_cqe *cqe = nullptr;
+        if (const int res = io_uring_wait_cqe(&ring, &cqe); res < 0) {
+            if (res == -EINTR) { continue; }
+            // The ring is broken, the remaining requests are written synchronously.
+            for (const Request &request : in_flight)
+                if (request.length > 0)
+                    this->complete(request, write_fully(request.file->fd, request.buffer, request.length,
+                                                        request.offset, 0));
+            io_uring_queue_exit(&ring);
+            this->run_pwrite();
+            return;
+        }
+        Request &request = in_flight[cqe->user_data];
+        long result = cqe->res;
+        io_uring_cqe_seen(&ring, cqe);
+        --running;
+
+        // Short writes are completed synchronously.
+        if (result >= 0 && static_cast<size_t>(result) < request.length)
+            result = write_fully(request.file->fd, request.buffer, request.length, request.offset,
+                                 static_cast<size_t>(result));
+        this->complete(request, result);
+        request.length = 0;
+    }
+    io_uring_queue_exit(&ring);
+#endif
+}
+
+// Return the buffer of a finished request to the pool, keeping the first error.
+void AsyncIO::complete(const Request &request, const long result) {
+    {
+        std::lock_guard lock(this->mutex);
+        if (result < 0 && this->error.empty())
+            this->error = "Could not write to '" + request.file->path + "': "
+                          + std::strerror(static_cast<int>(-result)) + ". Is the disk full?";
+        this->free_buffers.push_back(request.buffer);
+        --request.file->pending;
+    }
+    this->changed.notify_all();
+}
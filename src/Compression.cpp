@@ -0,0 +1,250 @@
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef GRAPHGEN_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef GRAPHGEN_HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+
+Compression detect_compression(const std::string_view content) {
+    if (content.size() >= 2 && content[0] == '\x1f' && content[1] == '\x8b')
+        return Compression::GZIP;
+    if (content.size() >= 4 && content.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4))
+        return Compression::ZSTD;
+    return Compression::NONE;
+}
+
+
+std::string compression_name(const Compression compression) {
+    switch (compression) {
+        case Compression::GZIP: return "gzip";
+        case Compression::ZSTD: return "zstd";
+        case Compression::NONE: break;
+    }
+    return "uncompressed";
+}
+
+
+
+
+#ifdef GRAPHGEN_HAVE_ZLIB
+// gzip-Decompression with zlib. Every member of a multi-member file is inflated in turn.
+class GzipDecompressor : public Decompressor {
+public:
+    explicit GzipDecompressor(const std::string_view input) {
+        this->stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+        this->stream.avail_in = 0;
+        this->remaining = input.size();
+        if (inflateInit2(&this->stream, 15 + 16) != Z_OK)
+            throw std::runtime_error("Could not initialize the gzip-decompression.");
+    }
+
+    ~GzipDecompressor() override {
+        inflateEnd(&this->stream);
+    }
+
+    size_t read(char *out, const size_t capacity) override {
+        this->stream.next_out = reinterpret_cast<Bytef *>(out);
+        this->stream.avail_out = static_cast<uInt>(std::min<size_t>(capacity, UINT32_MAX));
+
+        while (this->stream.avail_out > 0 && !this->finished) {
+            // zlib counts in 32 bit, larger inputs are passed in slices.
+            if (this->stream.avail_in == 0) {
+                const auto slice = static_cast<uInt>(std::min<size_t>(this->remaining, UINT32_MAX));
+                this->stream.avail_in = slice;
+                this->remaining -= slice;
+            }
+
+            const int status = inflate(&this->stream, Z_NO_FLUSH);
+            if (status == Z_STREAM_END) {
+                // Another member may follow, otherwise the file is complete.
+                if (this->stream.avail_in == 0 && this->remaining == 0)
+                    this->finished = true;
+                else if (inflateReset(&this->stream) != Z_OK)
+                    throw std::runtime_error("Could not continue with the next gzip-member.");
+            } else if (status == Z_BUF_ERROR && this->stream.avail_in == 0 && this->remaining == 0) {
+                throw std::runtime_error("Unexpected end of the gzip-stream. Is the file truncated?");
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                throw std::runtime_error(std::string("Invalid gzip-stream: ")
+                                         + (this->stream.msg ? this->stream.msg : "unknown error"));
+            }
+        }
+        return capacity - this->stream.avail_out;
+    }
+
+private:
+    z_stream stream{};
+    size_t remaining;
+    bool finished = false;
+};
+#endif
+
+
+#ifdef GRAPHGEN_HAVE_ZSTD
+// zstd-Decompression with libzstd. Subsequent frames are decoded by the same stream.
+class ZstdDecompressor : public Decompressor {
+public:
+    explicit ZstdDecompressor(const std::string_view input) {
+        this->stream = ZSTD_createDStream();
+        if (this->stream == nullptr)
+            throw std::runtime_error("Could not initialize the zstd-decompression.");
+        this->in = ZSTD_inBuffer{input.data(), input.size(), 0};
+    }
+
+    ~ZstdDecompressor() override {
+        ZSTD_freeDStream(this->stream);
+    }
+
+    size_t read(char *out, const size_t capacity) override {
+        ZSTD_outBuffer buffer{out, capacity, 0};
+        while (buffer.pos < buffer.size && this->in.pos < this->in.size) {
+            this->pending = ZSTD_decompressStream(this->stream, &buffer, &this->in);
+            if (ZSTD_isError(this->pending))
+                throw std::runtime_error(std::string("Invalid zstd-stream: ") + ZSTD_getErrorName(this->pending));
+        }
+        // A non-zero hint at the end of the input means an incomplete frame.
+        if (buffer.pos == 0 && this->pending != 0)
+            throw std::runtime_error("Unexpected end of the zstd-stream. Is the file truncated?");
+        return buffer.pos;
+    }
+
+private:
+    ZSTD_DStream *stream;
+    ZSTD_inBuffer in;
+    size_t pending = 0;
+};
+#endif
+
+
+[[noreturn]] static void missing_support(const Compression compression) {
+    throw std::runtime_error("The generator has been built without " + compression_name(compression) + "-support. "
+                             "Install the library and run CMake again.");
+}
+
+std::unique_ptr<Decompressor> Decompressor::create(const Compression compression, const std::string_view input) {
+    switch (compression) {
+        case Compression::GZIP:
+#ifdef GRAPHGEN_HAVE_ZLIB
+            return std::make_unique<GzipDecompressor>(input);
+#else
+            break;
+#endif
+        case Compression::ZSTD:
+#ifdef GRAPHGEN_HAVE_ZSTD
+            return std::make_unique<ZstdDecompressor>(input);
+#else
+            break;
+#endif
+        case Compression::NONE:
+            throw std::invalid_argument("Uncompressed inputs do not need a decompressor.");
+    }
+    missing_support(compression);
+}
+
+
+
+
+#ifdef GRAPHGEN_HAVE_ZLIB
+// A complete gzip-member of the data, zlib_level 0 only stores the data.
+static std::string gzip_block(const std::string_view data, const int zlib_level) {
+    if (data.size() > UINT32_MAX)
+        throw std::invalid_argument("Blocks for gzip-compression are limited to 4 GiB.");
+
+    z_stream stream{};
+    if (deflateInit2(&stream, zlib_level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("Could not initialize the gzip-compression.");
+    std::string out(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    const int status = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END)
+        throw std::runtime_error("Could not compress a gzip-member.");
+    return out;
+}
+#endif
+
+#ifdef GRAPHGEN_HAVE_ZSTD
+// A complete zstd-frame of the data. Every thread keeps its own context.
+static std::string zstd_block(const std::string_view data, const int level) {
+    thread_local const std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if (context == nullptr)
+        throw std::runtime_error("Could not initialize the zstd-compression.");
+
+    std::string out(ZSTD_compressBound(data.size()), '\0');
+    const size_t size = ZSTD_compressCCtx(context.get(), out.data(), out.size(), data.data(), data.size(), level);
+    if (ZSTD_isError(size))
+        throw std::runtime_error(std::string("Could not compress a zstd-frame: ") + ZSTD_getErrorName(size));
+    out.resize(size);
+    return out;
+}
+#endif
+
+
+std::string compress_block(const Compression compression, const std::string_view data, const int level) {
+    switch (compression) {
+        case Compression::GZIP:
+#ifdef GRAPHGEN_HAVE_ZLIB
+            return gzip_block(data, level == 0 ? Z_DEFAULT_COMPRESSION : level);
+#else
+            missing_support(compression);
+#endif
+        case Compression::ZSTD:
+#ifdef GRAPHGEN_HAVE_ZSTD
+            return zstd_block(data, level == 0 ? ZSTD_CLEVEL_DEFAULT : level);
+#else
+            missing_support(compression);
+#endif
+        case Compression::NONE:
+            break;
+    }
+    return std::string(data);
+}
+
+
+// Append the value as little-endian integer of the given number of bytes.
+static void put_le(std::string &out, uint64_t value, const int bytes) {
+    for (int i = 0; i < bytes; ++i, value >>= 8)
+        out += static_cast<char>(value & 0xFF);
+}
+
+std::string store_block(const Compression compression, const std::string_view data) {
+    switch (compression) {
+        case Compression::GZIP:
+#ifdef GRAPHGEN_HAVE_ZLIB
+            return gzip_block(data, Z_NO_COMPRESSION);
+#else
+            missing_support(compression);
+#endif
+        case Compression::ZSTD: {
+            // Frame with the content size (single segment) and raw blocks of at most 128 KiB (RFC 8878).
+            constexpr size_t MAX_BLOCK_SIZE = 128 * 1024;
+            std::string out;
+            put_le(out, 0xFD2FB528, 4);
+            out += static_cast<char>(0xE0);
+            put_le(out, data.size(), 8);
+            size_t pos = 0;
+            do {
+                const size_t length = std::min(data.size() - pos, MAX_BLOCK_SIZE);
+                const bool last = pos + length == data.size();
+                put_le(out, (length << 3) | (last ? 1 : 0), 3);
+                out.append(data.substr(pos, length));
+                pos += length;
+            } while (pos < data.size());
+            return out;
+        }
+        case Compression::NONE:
+            break;
+    }
+    return std::string(data);
+}
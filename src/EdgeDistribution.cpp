@@ -1,44 +1,44 @@
 #include "../include/GraphGenTypes.h"
+#include "../include/BinaryIO.h"
 
 
-EdgeDistribution::EdgeDistribution(std::unordered_map<Nodetype, Count> nodes,
-                                   const std::map<std::pair<Nodetype, Nodetype>, Count> &edges) {
+EdgeDistribution::EdgeDistribution(const std::vector<Count> &nodes,
+                                   const std::map<std::pair<Index, Index>, Count> &edges) {
     // Count the overall occurrences of NodeTypes, IF they habe outgoing edges.
     //      NodeTypes w/o outgoing edges will not be considered for the later process.
     // Count the overall outgoing Edges per NodeType of the start node.
     long long node_sum = 0;
-    std::unordered_map<Nodetype, long double> filtered_nodes;
-    std::unordered_map<Nodetype, Count> edge_sums;
+    std::unordered_map<Index, long double> filtered_nodes;
+    std::unordered_map<Index, Count> edge_sums;
 
     for (const auto &[key, value]: edges) {
         if (value > 0) {
-            Nodetype start_node_type = key.first;
+            const Index start_node_type = key.first;
             if (filtered_nodes.count(start_node_type) == 0) {
                 node_sum += nodes[start_node_type];
-                filtered_nodes[start_node_type] = nodes[start_node_type]; // This is inefficient...
+                filtered_nodes[start_node_type] = nodes[start_node_type];
             }
             edge_sums[start_node_type] += value;
         }
     }
 
     // Transform the NodeTypes-counts to the probabilities of a randomly picked node to be of this type.
-    for (const auto &[key, value]: filtered_nodes)
-        filtered_nodes[key] = value / node_sum;
+    for (auto &[_, value]: filtered_nodes)
+        value = value / node_sum;
 
     // Calculate the probability of a given edge-transition occurring:
     //      P(A->B) = P(Node of Type A) * P(Transition to B | Node of Type A)
     //      As "No-Transition" NodeTypes are removed beforehand, the resulting Probabilities should sum to 1.
-    std::vector<std::pair<probability, std::pair<Nodetype, Nodetype> > > edge_probabilities;
+    std::vector<std::pair<probability, TypeTransition> > edge_probabilities;
     for (const auto &[key, value]: edges) {
         if (value > 0) {
-            Nodetype start_node_type = key.first;
+            const Index start_node_type = key.first;
             auto prob = static_cast<double>(
-                (filtered_nodes[start_node_type] / node_sum)
-                * (static_cast<long double>(value) / edge_sums[start_node_type])
-
+                filtered_nodes[start_node_type] * (static_cast<long double>(value) / edge_sums[start_node_type])
             );
 
-            edge_probabilities.emplace_back(prob, key);
+            edge_probabilities.emplace_back(prob, TypeTransition{static_cast<uint32_t>(key.first),
+                                                                 static_cast<uint32_t>(key.second)});
         }
     }
 
@@ -50,10 +50,33 @@ EdgeDistribution::EdgeDistribution(std::unordered_map<Nodetype, Count> nodes,
 // Default initialization. Initializes the Table with the Default-Value for the given Type T.
 // Really only used as a dummy value for member-variables.
 EdgeDistribution::EdgeDistribution() {
-    this->transitions = AliasTable<std::pair<Nodetype, Nodetype> >();
+    this->transitions = AliasTable<TypeTransition>();
+}
+
+
+// Load an EdgeDistribution written by EdgeDistribution::save(). The table is used in place from the file.
+EdgeDistribution::EdgeDistribution(BinaryIn &in) {
+    this->transitions = load_alias_table<TypeTransition>(in);
+}
+
+
+void EdgeDistribution::save(BinaryOut &out) const {
+    save_alias_table(out, this->transitions);
 }
 
 
-std::pair<Nodetype, Nodetype> EdgeDistribution::getTransition() {
-    return transitions.getElement();
+const TypeTransition &EdgeDistribution::getTransition(CounterRng &rng) const {
+    return this->transitions.getElement(rng);
+}
+
+void EdgeDistribution::sampleTransitions(CounterRng &rng, const std::span<AliasIndex> out) const {
+    this->transitions.fill(rng, out);
+}
+
+const TypeTransition &EdgeDistribution::getTransitionByIndex(const AliasIndex idx) const {
+    return this->transitions.get_elements()[idx];
+}
+
+std::span<const TypeTransition> EdgeDistribution::getTransitions() const {
+    return this->transitions.get_elements();
 }
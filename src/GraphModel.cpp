@@ -1,93 +1,508 @@
 #include "../include/GraphGenTypes.h"
+#include "../include/BinaryIO.h"
+#include "../include/SimpleGraph.h"
 #include "chrono"
 #include "syncstream"
+#include <algorithm>
+#include <bit>
+#include <numeric>
 
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
-GraphModel::GraphModel(InputModel m, const long double scalingFactor) {
+
+// Identification of compiled models ("GGCMPL" + 0x0001). The version must be increased with every change of the layout.
+constexpr uint64_t COMPILED_MAGIC = 0x01004C504D434747;
+constexpr uint64_t COMPILED_VERSION = 2;
+
+// Number of edges drawn from one random stream. Blocks are the unit of parallel work, their streams are derived from
+//      the seed and the index of the block, so the generated edges do not depend on the number of threads.
+constexpr Count GENERATION_BLOCK_SIZE = 4096;
+
+
+// With a baseScalingFactor, the model only covers the difference between a graph of the baseScalingFactor,
+//      generated before with the same seed, and a graph of the scalingFactor (see the BASE_SCALE option).
+//      Every count c of the input is scaled to floor(c * scalingFactor) - floor(c * baseScalingFactor), so the
+//      nodes, degree-buckets and edges of both graphs add up to exactly those of a single graph of the scalingFactor.
+//      The new nodes get the IDs following the nodes of the base-graph. The new edges only connect new nodes, so the
+//      extended graph is the disjoint union of both graphs, not the graph of the scalingFactor.
+GraphModel::GraphModel(InputModel &m, const long double scalingFactor, const uint64_t seed,
+                       const long double baseScalingFactor) {
     if (!m.is_preprocessed)
         m.preprocess();
+    if (baseScalingFactor < 0 || baseScalingFactor >= scalingFactor)
+        throw std::invalid_argument("The base scaling-factor must be smaller than the scaling-factor.");
+    this->scale = scalingFactor;
+    this->seed = seed;
+
+    // The additional edges must not repeat the random streams of the base-graph.
+    if (baseScalingFactor > 0)
+        this->seed = derive_key(seed, std::bit_cast<uint64_t>(static_cast<double>(baseScalingFactor)));
+
+    const auto scaled_count = [&](const Count count) -> Count {
+        return std::floor(count * scalingFactor) - std::floor(count * baseScalingFactor);
+    };
+
+    // Types without any nodes (e.g. the type "" of undeclared nodes) are not generated. All other types get a slot
+    //      in this->nodes, in the order of their indices. The Edge-Distributions refer to the types by these slots.
+    const Index nbr_types = m.types.size();
+    std::vector<Index> slots(nbr_types, -1);
+    std::vector<Count> type_counts;
+    Count offset = 0;
+    for (Index t = 0; t < nbr_types; ++t) {
+        offset += std::floor(m.node_types[t] * baseScalingFactor);
+        if (scaled_count(m.node_types[t]) == 0) { continue; }
+        slots[t] = static_cast<Index>(type_counts.size());
+        type_counts.push_back(m.node_types[t]);
+    }
 
     // The number of nodes/edges to generate are derived from the number of nodes/edges from
     //    the InputModel and the scalingFactor.
-    for (const auto &[color, cts]: m.edge_count) {
-        this->nbr_edges[color] = std::floor(cts * scalingFactor);
-        this->edges[color] = EdgeDistribution(m.node_types, m.sbm_matrix[color]);
+    for (Index c = 0; c < m.colors.size(); ++c) {
+        const Edgecolor &color = m.colors.name(c);
+        this->nbr_edges[color] = scaled_count(m.edge_count[c]);
+
+        // Transitions from or to types without nodes have no endpoints to draw from and are left out.
+        std::map<std::pair<Index, Index>, Count> transitions;
+        for (Index s = 0; s < nbr_types; ++s)
+            for (Index e = 0; e < nbr_types; ++e)
+                if (const Count cts = m.sbm_matrix[c][s * nbr_types + e]; cts > 0 && slots[s] >= 0 && slots[e] >= 0)
+                    transitions[std::make_pair(slots[s], slots[e])] = cts;
+
+        // Without any known transition (e.g. only edges between undeclared nodes), the color can not be generated.
+        if (transitions.empty()) {
+            std::cerr << "[WARNING] No type-transitions are known for the color '" << color
+                      << "', no edges of this color will be generated." << std::endl;
+            this->nbr_edges.erase(color);
+            continue;
+        }
+        this->edges[color] = EdgeDistribution(type_counts, transitions);
     }
 
     // Crate the node-distributions. The number of nodes in each bucket needs to be scaled with the given factor.
-    Count offset = 0;
-    for (auto &[ntype, desired_node_count]: m.node_types) {
-        desired_node_count = std::floor(desired_node_count * scalingFactor);
+    for (Index t = 0; t < nbr_types; ++t) {
+        if (slots[t] < 0) { continue; }
+
+        const Nodetype &ntype = m.types.name(t);
+        const Count desired_node_count = scaled_count(m.node_types[t]);
         this->nbr_nodes += desired_node_count;
         std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count> > > in;
         std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count> > > out;
 
-        Count nbr_in_nodes = 0;
-        Count nbr_out_nodes = 0;
-        for (const auto &[ecolor, _]: m.in_distribution[ntype]) {
-            // Scale the distributions
-            const auto in_element = m.in_distribution[ntype][ecolor];
-            for (const auto &[deg, count]: in_element) {
-                if (deg == 0) { continue; }
-                Count rounded_nodes = std::floor(count * scalingFactor);
-                nbr_in_nodes += rounded_nodes;
-                in[ecolor].emplace_back(std::make_pair(deg, rounded_nodes));
-            }
-            const auto out_element = m.out_distribution[ntype][ecolor];
-            for (const auto &[deg, count]: out_element) {
-                if (deg == 0) { continue; }
-                Count rounded_nodes = std::floor(count * scalingFactor);
-                nbr_out_nodes += rounded_nodes;
-                out[ecolor].emplace_back(std::make_pair(deg, rounded_nodes));
-            }
+        for (Index c = 0; c < m.colors.size(); ++c) {
+            const Edgecolor &ecolor = m.colors.name(c);
 
-            // Pad with zero-degree nodes. This compensates for rounding-errors, as well as existing zero-nodes.
-            if (nbr_in_nodes < desired_node_count) {
-                in[ecolor].emplace_back(std::make_pair(0, desired_node_count-nbr_in_nodes));
-            }
-            if (nbr_out_nodes < desired_node_count) {
-                out[ecolor].emplace_back(std::make_pair(0, desired_node_count-nbr_out_nodes));
+            // Scale the distributions. Colors without edges in one direction are left out for this direction,
+            //      the NodeType provides a fallback for those.
+            for (auto [distribution, scaled] : {std::make_pair(&m.in_distribution, &in),
+                                                std::make_pair(&m.out_distribution, &out)}) {
+                const DegreeHistogram &histogram = (*distribution)[t][c];
+                if (histogram.empty()) { continue; }
+
+                Count nbr_scaled_nodes = 0;
+                for (const auto &[deg, count]: histogram) {
+                    if (deg == 0) { continue; }
+                    Count rounded_nodes = scaled_count(count);
+                    nbr_scaled_nodes += rounded_nodes;
+                    (*scaled)[ecolor].emplace_back(std::make_pair(deg, rounded_nodes));
+                }
+
+                // Pad with zero-degree nodes. This compensates for rounding-errors, as well as existing zero-nodes.
+                if (nbr_scaled_nodes < desired_node_count) {
+                    (*scaled)[ecolor].emplace_back(std::make_pair(0, desired_node_count - nbr_scaled_nodes));
+                }
             }
         }
 
-        this->nodes[ntype] = NodeType(ntype, offset, desired_node_count, in, out);
+        this->nodes.emplace_back(ntype, offset, desired_node_count, in, out, this->seed);
         offset += desired_node_count;
     }
 }
 
 
-GraphModel::GraphModel(const std::string &filepath, long double scalingFactor) {
-    // TODO: Construction from file
+// Load a compiled model written by GraphModel::save().
+// The model is already scaled, the given scalingFactor is only compared to the one the model was compiled with.
+// The hash-functions of the NodeTypes are part of the model, the given seed only determines the drawn edges.
+GraphModel::GraphModel(const std::string &filepath, const long double scalingFactor, const uint64_t seed) {
+    this->seed = seed;
+    BinaryIn in(filepath);
+    if (in.size() < sizeof(COMPILED_MAGIC) || in.get<uint64_t>() != COMPILED_MAGIC)
+        throw std::runtime_error("'" + filepath + "' is not a compiled model.");
+    if (const auto version = in.get<uint64_t>(); version != COMPILED_VERSION)
+        throw std::runtime_error("Compiled model '" + filepath + "' has version " + std::to_string(version)
+                                 + ", but version " + std::to_string(COMPILED_VERSION) + " is required. "
+                                 "Please compile the model again.");
+
+    this->scale = in.get<double>();
+    if (scalingFactor > 0 && std::abs(scalingFactor - this->scale) > 1e-6)
+        std::cerr << "[WARNING] The model '" << filepath << "' has been compiled with the scaling-factor "
+                  << static_cast<double>(this->scale) << ". The configured scaling-factor "
+                  << static_cast<double>(scalingFactor) << " is ignored." << std::endl;
+
+    this->nbr_nodes = in.get<Count>();
+    const auto nbr_colors = in.get<uint64_t>();
+    for (uint64_t i = 0; i < nbr_colors; ++i) {
+        const Edgecolor color = in.get_string();
+        this->nbr_edges[color] = in.get<Count>();
+        this->edges[color] = EdgeDistribution(in);
+    }
+
+    const auto nbr_types = in.get<uint64_t>();
+    this->nodes.reserve(nbr_types);
+    for (uint64_t i = 0; i < nbr_types; ++i)
+        this->nodes.emplace_back(in);
+
+    // The transitions are used as positions in this->nodes without any further checks during the generation.
+    for (const auto &[color, distribution]: this->edges)
+        for (const auto &[start, end]: distribution.getTransitions())
+            if (start >= nbr_types || end >= nbr_types)
+                throw std::runtime_error("Compiled model '" + filepath + "' contains a transition of the color '"
+                                         + color + "' to an unknown Node-Type.");
 }
 
 
-void GraphModel::generate(GraphWriter &writer) {
-    // Generate k random Edges for every color, with k = this->nbr_edges[color]:
+// Write the fully constructed model, including all alias-tables, prime-moduli and hash-parameters.
+// Loading the file only maps it into memory, so several processes on one machine share the same model in memory.
+void GraphModel::save(const std::string &filepath) const {
+    BinaryOut out(filepath);
+    out.put<uint64_t>(COMPILED_MAGIC);
+    out.put<uint64_t>(COMPILED_VERSION);
+    out.put<double>(static_cast<double>(this->scale));
+    out.put<Count>(this->nbr_nodes);
+
+    out.put<uint64_t>(this->nbr_edges.size());
     for (const auto &[color, cts]: this->nbr_edges) {
-        std::cout << "\tGenerating " << cts << " edges for the subgraph '" << color << "'... ";
+        out.put_string(color);
+        out.put<Count>(cts);
+        this->edges.at(color).save(out);
+    }
+
+    out.put<uint64_t>(this->nodes.size());
+    for (const NodeType &node_type: this->nodes)
+        node_type.save(out);
+
+    out.close();
+}
+
+
+// Up to memory_budget_bytes of drawn edges are kept at once (0: no limit), further buckets are handled in more passes.
+void GraphModel::enable_simple_graph(const size_t memory_budget_bytes) {
+    this->simple_graph = true;
+    this->simple_pass_edges = (memory_budget_bytes == 0) ? 0
+                              : std::max<Count>(static_cast<Count>(memory_budget_bytes / SIMPLE_PASS_BYTES_PER_EDGE), 1);
+}
+
+
+// First element of the given shard, if total elements are split into count contiguous, nearly equal parts.
+static Count shard_bound(const Count total, const Count index, const Count count) {
+    __extension__ typedef unsigned __int128 uint128;
+    return static_cast<Count>(static_cast<uint128>(total) * static_cast<uint128>(index) / static_cast<uint128>(count));
+}
+
+
+// Sampling-plan of a color: The samplers of all NodeTypes, indexed like the NodeTypes of the model, and the key of the
+//      random streams of its blocks. Only types occurring in a transition are needed, the edge-loop itself does no
+//      lookups by color.
+struct ColorPlan {
+    const EdgeDistribution &distribution;
+    Count edges;
+    uint64_t key;
+    std::vector<NodeSampler> start_samplers;
+    std::vector<NodeSampler> target_samplers;
+
+    ColorPlan(const std::vector<NodeType> &nodes, const Edgecolor &color, const EdgeDistribution &distribution,
+              const Count edges, const uint64_t seed)
+        : distribution(distribution), edges(edges), key(derive_key(seed, hash_name(color))),
+          start_samplers(nodes.size()), target_samplers(nodes.size()) {
+        for (const auto &[start_type, end_type] : distribution.getTransitions()) {
+            if (this->start_samplers[start_type].distribution == nullptr)
+                this->start_samplers[start_type] = nodes[start_type].get_start_sampler(color);
+            if (this->target_samplers[end_type].distribution == nullptr)
+                this->target_samplers[end_type] = nodes[end_type].get_target_sampler(color);
+        }
+    }
+
+    Count blocks() const {
+        return (this->edges + GENERATION_BLOCK_SIZE - 1) / GENERATION_BLOCK_SIZE;
+    }
+
+    // Draw the edges of the given block from its own stream. The types of their end-nodes are kept, if requested.
+    void draw_block(const Count block, std::vector<AliasIndex> &transitions, std::vector<Edge> &generated,
+                    std::vector<uint32_t> *end_types = nullptr) const {
+        CounterRng rng(derive_key(this->key, block));
+        const Count first = block * GENERATION_BLOCK_SIZE;
+        const Count last = std::min(this->edges, first + GENERATION_BLOCK_SIZE);
+
+        // Get the Types of the start/endpoints of all edges in the block (Stochastic-Block-Model)
+        const std::span<AliasIndex> block_transitions(transitions.data(), last - first);
+        this->distribution.sampleTransitions(rng, block_transitions);
 
-        #pragma omp parallel for
-        for (int i = 0; i < cts; ++i) {
-            // Get the Type of the start/endpoint of the edge (Stochastic-Block-Model)
-            auto [start_type, end_type] = this->edges[color].getTransition();
+        generated.clear();
+        if (end_types)
+            end_types->clear();
+        for (const AliasIndex transition : block_transitions) {
+            const auto &[start_type, end_type] = this->distribution.getTransitionByIndex(transition);
 
             // Get a concrete NodeID for to Nodes of the given type (Degree-Correction)
-            writer.writeEdge(color, this->nodes[start_type].get_start_node(color),
-                                       this->nodes[end_type].get_target_node(color));
+            const NodeID start = this->start_samplers[start_type].draw(rng);
+            const NodeID end = this->target_samplers[end_type].draw(rng);
+            generated.push_back(Edge{start, end});
+            if (end_types)
+                end_types->push_back(end_type);
+        }
+    }
+};
+
+
+// Number of edges in every bucket of a simple color, before any edge is rejected.
+static std::vector<Count> count_buckets(const ColorPlan &plan, const Count buckets) {
+    std::vector<Count> counts(buckets, 0);
+    #pragma omp parallel
+    {
+        std::vector<Count> local(buckets, 0);
+        std::vector<Edge> generated;
+        generated.reserve(GENERATION_BLOCK_SIZE);
+        std::vector<AliasIndex> transitions(GENERATION_BLOCK_SIZE);
+
+        #pragma omp for schedule(dynamic, 1) nowait
+        for (Count block = 0; block < plan.blocks(); ++block) {
+            plan.draw_block(block, transitions, generated);
+            for (const Edge &edge : generated)
+                ++local[simple_bucket(edge.start, buckets)];
+        }
+
+        #pragma omp critical
+        for (Count bucket = 0; bucket < buckets; ++bucket)
+            counts[bucket] += local[bucket];
+    }
+    return counts;
+}
+
+
+// Make the buckets [first_bucket, last_bucket) of a color simple and pass them to the writer from the given position,
+//      bucket by bucket and the edges of every bucket in order of their positions. Every pass draws all edges of the
+//      color again and only keeps those of its buckets, up to max_pass_edges (by the counts of the buckets, 0: all).
+static SimpleGraphStats write_simple_buckets(GraphWriter &writer, const ColorPlan &plan, const Edgecolor &color,
+                                             const Index color_id, Count position, const Count buckets,
+                                             const Count first_bucket, const Count last_bucket,
+                                             const std::vector<Count> &counts, const Count max_pass_edges) {
+#ifdef _OPENMP
+    const auto threads = static_cast<size_t>(omp_get_max_threads());
+#else
+    const size_t threads = 1;
+#endif
+    const uint64_t simple_key = derive_key(plan.key, hash_name("simple-graph"));
+    SimpleGraphStats stats;
+    std::vector<Edge> batch;
+    batch.reserve(GENERATION_BLOCK_SIZE);
+
+    for (Count pass_first = first_bucket; pass_first < last_bucket;) {
+        Count pass_last = last_bucket;
+        if (max_pass_edges > 0) {
+            Count pass_edges = counts[pass_first];
+            pass_last = pass_first + 1;
+            while (pass_last < last_bucket && pass_edges + counts[pass_last] <= max_pass_edges)
+                pass_edges += counts[pass_last++];
+        }
+
+        // Collect the edges of the buckets of this pass. The static schedule hands out contiguous ranges of blocks in
+        //      the order of the threads, so the edges of a bucket are in order of their positions when the lists are
+        //      visited by thread.
+        struct Drawn {
+            Edge edge;
+            uint32_t end_type;
+        };
+        std::vector<std::vector<std::vector<Drawn> > > scattered(
+            threads, std::vector<std::vector<Drawn> >(pass_last - pass_first));
+        #pragma omp parallel
+        {
+#ifdef _OPENMP
+            const auto thread = static_cast<size_t>(omp_get_thread_num());
+#else
+            const size_t thread = 0;
+#endif
+            std::vector<Edge> generated;
+            generated.reserve(GENERATION_BLOCK_SIZE);
+            std::vector<uint32_t> end_types;
+            end_types.reserve(GENERATION_BLOCK_SIZE);
+            std::vector<AliasIndex> transitions(GENERATION_BLOCK_SIZE);
+
+            #pragma omp for schedule(static)
+            for (Count block = 0; block < plan.blocks(); ++block) {
+                plan.draw_block(block, transitions, generated, &end_types);
+                for (size_t i = 0; i < generated.size(); ++i)
+                    if (const Count bucket = simple_bucket(generated[i].start, buckets);
+                        bucket >= pass_first && bucket < pass_last)
+                        scattered[thread][bucket - pass_first].push_back(Drawn{generated[i], end_types[i]});
+            }
+        }
+
+        for (Count bucket = pass_first; bucket < pass_last; ++bucket) {
+            std::vector<Edge> edges;
+            std::vector<uint32_t> end_types;
+            for (size_t t = 0; t < threads; ++t) {
+                for (const auto &[edge, end_type] : scattered[t][bucket - pass_first]) {
+                    edges.push_back(edge);
+                    end_types.push_back(end_type);
+                }
+                std::vector<Drawn>().swap(scattered[t][bucket - pass_first]);
+            }
+
+            const SimpleGraphStats bucket_stats = make_simple(edges, derive_key(simple_key, bucket),
+                [&](const Count pos, CounterRng &rng) { return plan.target_samplers[end_types[pos]].draw(rng); });
+            stats.self_loops += bucket_stats.self_loops;
+            stats.duplicates += bucket_stats.duplicates;
+            stats.dropped += bucket_stats.dropped;
+
+            // Edges without a valid replacement are left out, the following edges move up.
+            for (const Edge &edge : edges) {
+                if (edge.start == NO_EDGE.start) { continue; }
+                batch.push_back(edge);
+                if (batch.size() == GENERATION_BLOCK_SIZE) {
+                    writer.writeEdges(EdgeBatch{color, color_id, position, batch});
+                    position += static_cast<Count>(batch.size());
+                    batch.clear();
+                }
+            }
+        }
+        pass_first = pass_last;
+    }
+    if (!batch.empty())
+        writer.writeEdges(EdgeBatch{color, color_id, position, batch});
+    return stats;
+}
+
+
+// Generate the shard shard_index of shard_count. The edges and nodes passed to the writers of all shards, concatenated
+//      in the order of their indices, are identical to those of a single run with the same seed (and so are the files
+//      of a plain TSVWriter, see the SHARD_COUNT option):
+//      The blocks of all colors (in order of their names) and the NodeIDs are split into contiguous parts.
+//      In a simple graph, the buckets of all colors are split instead (see SimpleGraph.h). Every shard draws all edges
+//      of a color to find those of its buckets, once to count them and once per pass.
+void GraphModel::generate(GraphWriter &writer, const Count shard_index, const Count shard_count) {
+    if (shard_count < 1 || shard_index < 0 || shard_index >= shard_count)
+        throw std::invalid_argument("Invalid shard " + std::to_string(shard_index) + "/" + std::to_string(shard_count)
+                                    + ", expected 0 <= index < count.");
+
+    // Colors are processed in a fixed order (by name), independent of how the model was created.
+    std::map<Edgecolor, Count> ordered_edges(this->nbr_edges.begin(), this->nbr_edges.end());
+    std::vector<ColorPlan> plans;
+    for (const auto &[color, cts]: ordered_edges)
+        plans.emplace_back(this->nodes, color, this->edges.at(color), cts, this->seed);
+
+    // The units split into shards: The blocks of the colors, or their buckets in a simple graph.
+    const auto units = [&](const ColorPlan &plan) {
+        return this->simple_graph ? simple_buckets(plan.edges) : plan.blocks();
+    };
+    Count total_units = 0;
+    for (const ColorPlan &plan : plans)
+        total_units += units(plan);
+    const Count shard_first_unit = shard_bound(total_units, shard_index, shard_count);
+    const Count shard_last_unit = shard_bound(total_units, shard_index + 1, shard_count);
+
+    // Announce the edges and nodes of the shard to the writer. Shards of a simple graph count the edges of the buckets
+    //      before them, unless they write the whole color. Passes need the counts of their own buckets.
+    GraphSchema schema;
+    std::vector<std::pair<Count, Count> > unit_ranges;
+    std::vector<std::vector<Count> > bucket_counts(plans.size());
+    Count color_first_unit = 0;
+    for (size_t c = 0; c < plans.size(); ++c) {
+        const ColorPlan &plan = plans[c];
+        const Edgecolor &color = std::next(ordered_edges.begin(), static_cast<std::ptrdiff_t>(c))->first;
+        const Count color_units = units(plan);
+        const Count first_unit = std::clamp(shard_first_unit - color_first_unit, Count{0}, color_units);
+        const Count last_unit = std::clamp(shard_last_unit - color_first_unit, Count{0}, color_units);
+        color_first_unit += color_units;
+        unit_ranges.emplace_back(first_unit, last_unit);
+
+        if (!this->simple_graph) {
+            const Count first = first_unit * GENERATION_BLOCK_SIZE;
+            schema.colors.push_back({color, first, std::min(plan.edges, last_unit * GENERATION_BLOCK_SIZE)
+                                                   - std::min(plan.edges, first)});
+        } else if (first_unit == last_unit) {
+            schema.colors.push_back({color, 0, 0});
+        } else if (first_unit == 0 && last_unit == color_units && this->simple_pass_edges == 0) {
+            schema.colors.push_back({color, 0, plan.edges});
+        } else {
+            bucket_counts[c] = count_buckets(plan, color_units);
+            const auto begin = bucket_counts[c].begin();
+            const Count first = std::accumulate(begin, begin + first_unit, Count{0});
+            schema.colors.push_back({color, first, std::accumulate(begin + first_unit, begin + last_unit, Count{0})});
+        }
+    }
+    const NodeID first_id = this->nodes.empty() ? 0 : this->nodes.front().get_offset();
+    const NodeID shard_first_node = first_id + shard_bound(this->nbr_nodes, shard_index, shard_count);
+    const NodeID shard_last_node = first_id + shard_bound(this->nbr_nodes, shard_index + 1, shard_count);
+    for (const NodeType &node: this->nodes) {
+        const NodeID first = std::max<NodeID>(node.get_offset(), shard_first_node);
+        const NodeID last = std::min<NodeID>(node.get_offset() + node.get_size(), shard_last_node);
+        if (first < last)
+            schema.types.push_back({node.get_type_name(), first, last - first});
+    }
+    schema.first_node = first_id;
+    schema.nbr_nodes = this->nbr_nodes;
+    writer.begin(schema);
+
+    // Generate k random Edges for every color, with k = this->nbr_edges[color]:
+    for (size_t c = 0; c < plans.size(); ++c) {
+        const ColorPlan &plan = plans[c];
+        const auto color_id = static_cast<Index>(c);
+        const Edgecolor &color = schema.colors[c].name;
 
+        const auto [first_unit, last_unit] = unit_ranges[c];
+        if (first_unit == last_unit) { continue; }
+
+        if (this->simple_graph) {
+            std::cout << "\tGenerating " << schema.colors[c].count << " edges for the subgraph '" << color << "'... ";
+            const SimpleGraphStats stats = write_simple_buckets(writer, plan, color, color_id, schema.colors[c].first,
+                                                                simple_buckets(plan.edges), first_unit, last_unit,
+                                                                bucket_counts[c], this->simple_pass_edges);
+            std::cout << "OK. Rejected " << stats.self_loops << " self-loops and " << stats.duplicates
+                      << " duplicates of the color." << std::endl;
+            if (stats.dropped > 0)
+                std::cerr << "[WARNING] No simple replacement has been found for " << stats.dropped << " edges of the color '"
+                          << color << "', they are left out." << std::endl;
+            continue;
+        }
+
+        std::cout << "\tGenerating " << schema.colors[c].count << " edges for the subgraph '" << color << "'... ";
+        #pragma omp parallel
+        {
+            // Every thread fills its own buffers, the edges are handed to the writer as a whole.
+            std::vector<Edge> generated;
+            generated.reserve(GENERATION_BLOCK_SIZE);
+            std::vector<AliasIndex> transitions(GENERATION_BLOCK_SIZE);
+
+            if (writer.ordered()) {
+                #pragma omp for ordered schedule(dynamic, 1)
+                for (Count block = first_unit; block < last_unit; ++block) {
+                    plan.draw_block(block, transitions, generated);
+
+                    // Blocks are passed to the writer in their order, so the output is identical for any number of threads.
+                    #pragma omp ordered
+                    writer.writeEdges(EdgeBatch{color, color_id, block * GENERATION_BLOCK_SIZE, generated});
+                }
+            } else {
+                // The writer places the blocks by their position itself, no thread has to wait for its predecessors.
+                #pragma omp for schedule(dynamic, 1)
+                for (Count block = first_unit; block < last_unit; ++block) {
+                    plan.draw_block(block, transitions, generated);
+                    writer.writeEdges(EdgeBatch{color, color_id, block * GENERATION_BLOCK_SIZE, generated});
+                }
+            }
         }
         std::cout << "OK." << std::endl;
     }
     std::cout << std::endl;
 
-    // Write alle nodes to a file
-    for (const auto &[nodetype, node]: this->nodes) {
-        #pragma omp parallel for
-        for (NodeID i = node.get_offset(); i < node.get_offset() + node.get_size(); ++i) {
-            writer.writeNode(nodetype, i);
-        }
+    // Write alle nodes of the shard to a file
+    for (const auto &[nodetype, first, count]: schema.types) {
+        const NodeID last = first + count;
+        writer.writeNodeRange(nodetype, first, last);
 
-        std::cout << "\tNodetype '" << nodetype << "' between ID "
-        << node.get_offset() << " and " << node.get_offset() + node.get_size() - 1 << std::endl;
+        std::cout << "\tNodetype '" << nodetype << "' between ID " << first << " and " << last - 1 << std::endl;
     }
+
+    writer.finish();
 }
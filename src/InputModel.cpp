@@ -1,90 +1,622 @@
 #include "../include/GraphGenTypes.h"
+#include "../include/BinaryIO.h"
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <limits>
 #include <iostream>
+#include <stdexcept>
+
+
+// Identification of model snapshots ("GGMODEL" + 0x01). The version must be increased with every change of the layout.
+constexpr uint64_t SNAPSHOT_MAGIC = 0x014C45444F4D4747;
+constexpr uint64_t SNAPSHOT_VERSION = 1;
+
+// Numeric node-IDs below 4 * #nodes + DENSE_ID_SLACK are stored in a vector instead of a hash-map.
+constexpr size_t DENSE_ID_SLACK = 1 << 20;
+
+
+Index Interner::intern(const std::string_view name) {
+    if (const auto it = this->indices.find(name); it != this->indices.end())
+        return it->second;
+
+    const Index idx = static_cast<Index>(this->names.size());
+    this->names.emplace_back(name);
+    this->indices.emplace(this->names.back(), idx);
+    return idx;
+}
+
+Index Interner::find(const std::string_view name) const {
+    const auto it = this->indices.find(name);
+    return (it == this->indices.end()) ? -1 : it->second;
+}
+
+const std::string &Interner::name(const Index idx) const {
+    return this->names[idx];
+}
+
+Index Interner::size() const {
+    return static_cast<Index>(this->names.size());
+}
+
+
+
 
 InputModel::InputModel() {
     this->is_preprocessed = false;
 }
 
+// Load a preprocessed model from a snapshot written by InputModel::save().
 InputModel::InputModel(const std::string &filepath) {
-    // Todo: Read the raw model from the given file.
-    // Todo: Custom-Convert the resulting JSON to the object.
+    BinaryIn in(filepath);
+    if (in.size() < sizeof(SNAPSHOT_MAGIC) || in.get<uint64_t>() != SNAPSHOT_MAGIC)
+        throw std::runtime_error("'" + filepath + "' is not a model snapshot.");
+    if (const auto version = in.get<uint64_t>(); version != SNAPSHOT_VERSION)
+        throw std::runtime_error("Model snapshot '" + filepath + "' has version " + std::to_string(version)
+                                 + ", but version " + std::to_string(SNAPSHOT_VERSION) + " is required. "
+                                 "Please re-create the snapshot from the original input.");
+
+    this->node_count = in.get<Count>();
+    const auto nbr_types = in.get<uint64_t>();
+    const auto nbr_colors = in.get<uint64_t>();
+    for (uint64_t t = 0; t < nbr_types; ++t)
+        this->types.intern(in.get_string());
+    for (uint64_t c = 0; c < nbr_colors; ++c)
+        this->colors.intern(in.get_string());
+
+    this->node_types = in.get_array<Count>();
+    this->edge_count = in.get_array<Count>();
+    for (uint64_t c = 0; c < nbr_colors; ++c)
+        this->sbm_matrix.push_back(in.get_array<Count>());
+    if (this->node_types.size() != nbr_types || this->edge_count.size() != nbr_colors
+        || std::any_of(this->sbm_matrix.begin(), this->sbm_matrix.end(),
+                       [nbr_types](const auto &m) { return m.size() != nbr_types * nbr_types; }))
+        throw std::runtime_error("Model snapshot '" + filepath + "' is corrupted.");
+
+    // Histograms are stored as flat arrays of (degree, count)-pairs
+    for (auto *distribution : {&this->in_distribution, &this->out_distribution}) {
+        distribution->assign(nbr_types, std::vector<DegreeHistogram>(nbr_colors));
+        for (auto &per_type : *distribution) {
+            for (auto &histogram : per_type) {
+                const std::span<const Count> flat = in.view_array<Count>();
+                if (flat.size() % 2 != 0)
+                    throw std::runtime_error("Model snapshot '" + filepath + "' is corrupted.");
+                for (size_t i = 0; i < flat.size(); i += 2)
+                    histogram.emplace_back(flat[i], flat[i + 1]);
+            }
+        }
+    }
+
     this->is_preprocessed = true;
 }
 
-void InputModel::readNode(const std::string &node, const std::string &node_type) {
+
+// Re-Layout a (old_size x old_size)-Matrix to (n x n). Empty matrices stay empty.
+static void grow_matrix(std::vector<Count> &matrix, const Index old_size, const Index n) {
+    if (matrix.empty()) { return; }
+
+    std::vector<Count> grown(n * n, 0);
+    for (Index s = 0; s < old_size; ++s)
+        for (Index e = 0; e < old_size; ++e)
+            grown[s * n + e] = matrix[s * old_size + e];
+    matrix = std::move(grown);
+}
+
+
+// Sampling-level of a node: The number of leading zero-bits of its hash, so every level halves the probability.
+// std::hash only guarantees distinct values, the bits are mixed with the SplitMix64-finalizer.
+static int mixed_level(uint64_t h) {
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h = h ^ (h >> 31);
+    return std::min(std::countl_zero(h), 63);
+}
+
+static int sample_level_of(const std::string_view node) {
+    return mixed_level(std::hash<std::string_view>{}(node));
+}
+
+// Numeric IDs are often consecutive, the golden-ratio increment of SplitMix64 spreads them before mixing.
+static int sample_level_of(const NodeID node) {
+    return mixed_level(static_cast<uint64_t>(node) + 0x9e3779b97f4a7c15ULL);
+}
+
+
+// Intern the given Node-Type. New types grow the per-type counters and the SBM-Matrices of every color.
+Index InputModel::type_index(const std::string_view node_type) {
+    const Index old_size = this->types.size();
+    const Index idx = this->types.intern(node_type);
+    if (this->types.size() == old_size)
+        return idx;
+
+    const Index n = this->types.size();
+    this->node_types.push_back(0);
+
+    // Re-Layout the existing Matrices. Types usually appear before the first edge,
+    //      so this only happens for nodes without a known type ("").
+    for (auto &matrix : this->sbm_matrix)
+        grow_matrix(matrix, old_size, n);
+    for (auto &levels : this->sbm_levels)
+        for (auto &matrix : levels)
+            grow_matrix(matrix, old_size, n);
+    return idx;
+}
+
+
+// Intern the given Edge-Color and create its (empty) counters.
+Index InputModel::color_index(const std::string_view color) {
+    const Index idx = this->colors.intern(color);
+    if (idx == static_cast<Index>(this->edge_count.size())) {
+        this->edge_count.push_back(0);
+        this->sbm_matrix.emplace_back(this->types.size() * this->types.size(), 0);
+        this->in_degrees.emplace_back();
+        this->out_degrees.emplace_back();
+        this->sbm_levels.emplace_back(64);
+    }
+    return idx;
+}
+
+
+// Look up the dense index of the given node.
+// Nodes that have not been declared in any node-file are registered with the empty type "".
+Index InputModel::node_index(const std::string_view node, const Index new_type) {
+    if (const auto it = this->node_ids.find(node); it != this->node_ids.end())
+        return it->second;
+
+    const Index idx = static_cast<Index>(this->node_type_of.size());
+    this->node_type_of.push_back(new_type >= 0 ? new_type : this->type_index(""));
+    this->node_ids.emplace(std::string(node), idx);
+    if (node.size() >= sizeof(std::string))
+        this->long_id_bytes += node.size() + 1;
+    return idx;
+}
+
+Index InputModel::node_index(const NodeID node, const Index new_type) {
+    if (node >= 0 && static_cast<size_t>(node) < this->dense_node_ids.size() && this->dense_node_ids[node] >= 0)
+        return this->dense_node_ids[node];
+    if (!this->numeric_node_ids.empty())
+        if (const auto it = this->numeric_node_ids.find(node); it != this->numeric_node_ids.end())
+            return it->second;
+
+    const Index idx = static_cast<Index>(this->node_type_of.size());
+    this->node_type_of.push_back(new_type >= 0 ? new_type : this->type_index(""));
+
+    // IDs up to a few times the number of nodes go to the vector, so it stays reasonably filled.
+    //      The approximate ingestion only tracks a sparse sample of the IDs and always hashes them.
+    const auto limit = static_cast<NodeID>(4 * this->node_type_of.size() + DENSE_ID_SLACK);
+    if (this->memory_budget == 0 && node >= 0 && node < limit) {
+        if (static_cast<size_t>(node) >= this->dense_node_ids.size())
+            this->dense_node_ids.resize(std::max(static_cast<size_t>(node) + 1, 2 * this->dense_node_ids.size()), -1);
+        this->dense_node_ids[node] = idx;
+    } else {
+        this->numeric_node_ids.emplace(node, idx);
+    }
+    return idx;
+}
+
+
+// Numeric node-IDs are only recognized in their canonical decimal form (no sign, no leading zeros),
+//      so every numeric ID has a single spelling and "42"/"042" remain different nodes.
+static bool parse_numeric_id(const std::string_view node, NodeID &id) {
+    if (node.empty() || node[0] < '0' || node[0] > '9' || (node[0] == '0' && node.size() > 1))
+        return false;
+    const auto [end, error] = std::from_chars(node.data(), node.data() + node.size(), id);
+    return error == std::errc() && end == node.data() + node.size();
+}
+
+
+void InputModel::readNode(const std::string_view node, const std::string_view node_type) {
+    if (NodeID id; parse_numeric_id(node, id))
+        this->add_node(id, this->type_index(node_type));
+    else
+        this->add_node(node, this->type_index(node_type));
+}
+
+void InputModel::readNode(const NodeID node, const Index type) {
+    if (type < 0 || type >= this->types.size())
+        throw std::out_of_range("Unknown node-type index " + std::to_string(type) + ".");
+    this->add_node(node, type);
+}
+
+
+void InputModel::readEdge(const std::string_view start, const std::string_view end, const std::string_view color) {
+    const Index c = this->color_index(color);
+
+    // Every endpoint is looked up by its own kind of ID.
+    NodeID id_start;
+    NodeID id_end;
+    const bool numeric_start = parse_numeric_id(start, id_start);
+    const bool numeric_end = parse_numeric_id(end, id_end);
+    if (numeric_start && numeric_end)
+        this->add_edge(id_start, id_end, c);
+    else if (numeric_start)
+        this->add_edge(id_start, end, c);
+    else if (numeric_end)
+        this->add_edge(start, id_end, c);
+    else
+        this->add_edge(start, end, c);
+}
+
+void InputModel::readEdge(const NodeID start, const NodeID end, const Index color) {
+    if (color < 0 || color >= this->colors.size())
+        throw std::out_of_range("Unknown edge-color index " + std::to_string(color) + ".");
+    this->add_edge(start, end, color);
+}
+
+
+Index InputChunk::local_index(std::unordered_map<std::string_view, Index> &indices,
+                              std::vector<std::string_view> &names, const std::string_view name) {
+    const auto [it, inserted] = indices.try_emplace(name, static_cast<Index>(names.size()));
+    if (inserted)
+        names.push_back(name);
+    return it->second;
+}
+
+NodeID InputChunk::node_key(const std::string_view node) {
+    if (NodeID id; parse_numeric_id(node, id))
+        return id;
+    return -1 - local_index(this->name_indices, this->names, node);
+}
+
+void InputChunk::readNode(const std::string_view node, const std::string_view node_type) {
+    const Index type = local_index(this->type_indices, this->types, node_type);
+    this->nodes.emplace_back(this->node_key(node), type);
+}
+
+void InputChunk::readEdge(const std::string_view start, const std::string_view end, const std::string_view color) {
+    const Index c = local_index(this->color_indices, this->colors, color);
+    const Index s = this->node_key(start);
+    const Index e = this->node_key(end);
+    this->edges.push_back(LocalEdge{s, e, c});
+}
+
+
+template<typename Key>
+void InputModel::add_node(const Key node, const Index type) {
+    if (this->is_preprocessed)
+        throw std::runtime_error("The model has already been preprocessed, no further nodes can be read.");
     ++this->node_count;
 
     // Increase the count of the node-color
-    ++this->node_types[node_type];
+    ++this->node_types[type];
+
+    // Approximate ingestion: Nodes outside of the sample are only counted.
+    if (this->memory_budget > 0) {
+        if (++this->reads_since_check == 0x10000)
+            this->enforce_memory_budget();
+        if (sample_level_of(node) < this->sample_level)
+            return;
+    }
 
     // Remember this node for future lookups
-    this->nodes_to_types[node] = node_type;
+    this->node_type_of[this->node_index(node, type)] = type;
+}
+
+
+template<typename StartKey, typename EndKey>
+void InputModel::add_edge(const StartKey start, const EndKey end, const Index c) {
+    if (this->is_preprocessed)
+        throw std::runtime_error("The model has already been preprocessed, no further edges can be read.");
+    ++this->edge_count[c];
+
+    // Approximate ingestion: Only the endpoints within the sample are tracked (index -1 otherwise).
+    Index id_start;
+    Index id_end;
+    if (this->memory_budget > 0) {
+        if (++this->reads_since_check == 0x10000)
+            this->enforce_memory_budget();
+        const int level_start = sample_level_of(start);
+        const int level_end = sample_level_of(end);
+        id_start = (level_start >= this->sample_level) ? this->node_index(start) : -1;
+        id_end = (level_end >= this->sample_level) ? this->node_index(end) : -1;
+
+        // The transition is only known, if both endpoints are sampled. It is kept until the level of the edge is dropped.
+        if (id_start >= 0 && id_end >= 0) {
+            const Index n = this->types.size();
+            std::vector<Count> &matrix = this->sbm_levels[c][std::min(level_start, level_end)];
+            if (matrix.empty())
+                matrix.resize(n * n, 0);
+            ++matrix[this->node_type_of[id_start] * n + this->node_type_of[id_end]];
+        }
+    } else {
+        // Increase the entry in the SBM-Matrix
+        id_start = this->node_index(start);
+        id_end = this->node_index(end);
+        const Index n = this->types.size();
+        ++this->sbm_matrix[c][this->node_type_of[id_start] * n + this->node_type_of[id_end]];
+    }
+
+    // Increase In/Out Degree of the node. The counters grow with the number of known nodes.
+    if (id_start >= 0) {
+        std::vector<Count> &out = this->out_degrees[c];
+        if (static_cast<size_t>(id_start) >= out.size())
+            out.resize(std::max(this->node_type_of.size(), static_cast<size_t>(id_start) + 1), 0);
+        ++out[id_start];
+    }
+    if (id_end >= 0) {
+        std::vector<Count> &in = this->in_degrees[c];
+        if (static_cast<size_t>(id_end) >= in.size())
+            in.resize(std::max(this->node_type_of.size(), static_cast<size_t>(id_end) + 1), 0);
+        ++in[id_end];
+    }
 }
 
 
-void InputModel::readEdge(const std::string &start, const std::string &end, const Edgecolor &color) {
-    ++this->edge_count[color];
+// Add the rows of a concurrently interned chunk: Only its distinct types, colors and node-names are looked up here.
+//      The nodes of a chunk are added before its edges, the readers never mix both in one chunk.
+void InputModel::merge(const InputChunk &chunk) {
+    if (this->is_preprocessed)
+        throw std::runtime_error("The model has already been preprocessed, no further nodes or edges can be read.");
+
+    const auto visit = [&chunk](const NodeID key, const auto &f) {
+        if (key >= 0)
+            f(key);
+        else
+            f(chunk.names[-1 - key]);
+    };
+
+    std::vector<Index> types;
+    std::vector<Index> colors;
+    for (const std::string_view name : chunk.types)
+        types.push_back(this->type_index(name));
+    for (const std::string_view name : chunk.colors)
+        colors.push_back(this->color_index(name));
+
+    for (const auto &[node, type] : chunk.nodes)
+        visit(node, [&](const auto key) { this->add_node(key, types[type]); });
+
+    // Approximate ingestion: Every single edge decides, which of its endpoints are tracked.
+    if (this->memory_budget > 0) {
+        for (const InputChunk::LocalEdge &edge : chunk.edges)
+            visit(edge.start, [&](const auto start) {
+                visit(edge.end, [&](const auto end) { this->add_edge(start, end, colors[edge.color]); });
+            });
+        return;
+    }
 
-    // Increase the entry in the SBM-Matrix
-    Nodetype type_start = this->nodes_to_types[start];
-    Nodetype type_end = this->nodes_to_types[end];
-    ++this->sbm_matrix[color][std::make_pair(type_start, type_end)];
+    // Endpoints are looked up in the order of the rows, so new nodes get the same indices as row by row.
+    //      Every name is hashed once per chunk, numeric IDs mostly hit the dense vector.
+    std::vector<Index> named(chunk.names.size(), -1);
+    const auto lookup = [&](const NodeID key) {
+        if (key >= 0)
+            return this->node_index(key);
+        Index &idx = named[-1 - key];
+        if (idx < 0)
+            idx = this->node_index(chunk.names[-1 - key]);
+        return idx;
+    };
 
-    // Increase In/Out Degree of the node
-    ++this->out_degrees[color][start];
-    ++this->in_degrees[color][end];
+    for (const InputChunk::LocalEdge &edge : chunk.edges) {
+        const Index c = colors[edge.color];
+        const Index start = lookup(edge.start);
+        const Index end = lookup(edge.end);
+        const auto known_nodes = static_cast<size_t>(std::max(start, end)) + 1;
+        std::vector<Count> &out = this->out_degrees[c];
+        std::vector<Count> &in = this->in_degrees[c];
+        if (out.size() < known_nodes)
+            out.resize(std::max(this->node_type_of.size(), known_nodes), 0);
+        if (in.size() < known_nodes)
+            in.resize(std::max(this->node_type_of.size(), known_nodes), 0);
 
-    // Add the Color to the set of Edge-Colors
-    this->edge_colors.insert(color);
+        const Index n = this->types.size();
+        ++this->edge_count[c];
+        ++this->sbm_matrix[c][this->node_type_of[start] * n + this->node_type_of[end]];
+        ++out[start];
+        ++in[end];
+    }
+}
+
+
+// Enable the approximate ingestion: The per-node state is limited to roughly the given number of bytes.
+// Whenever the budget is exceeded, the sampling-level is raised and half of the tracked nodes (by hash) are dropped.
+// Node- and Edge-Counts stay exact, degree-histograms and type-transitions are estimated from the sample.
+void InputModel::enable_sampling(const size_t memory_budget_bytes) {
+    if (this->node_count > 0 || !this->edge_count.empty())
+        throw std::runtime_error("Sampling must be enabled before any nodes or edges are read.");
+    this->memory_budget = memory_budget_bytes;
+}
+
+
+// Approximate size of the per-node state in bytes
+size_t InputModel::tracked_bytes() const {
+    // Every entry of the id-map is a separately allocated node with a std::string-key and the cached hash.
+    size_t bytes = this->node_ids.size() * (sizeof(std::pair<const std::string, Index>) + 2 * sizeof(void *))
+                   + this->node_ids.bucket_count() * sizeof(void *) + this->long_id_bytes;
+    bytes += this->dense_node_ids.capacity() * sizeof(Index);
+    bytes += this->numeric_node_ids.size() * (sizeof(std::pair<const NodeID, Index>) + 2 * sizeof(void *))
+             + this->numeric_node_ids.bucket_count() * sizeof(void *);
+    bytes += this->node_type_of.capacity() * sizeof(Index);
+    for (const auto *degrees : {&this->in_degrees, &this->out_degrees})
+        for (const auto &counters : *degrees)
+            bytes += counters.capacity() * sizeof(Count);
+    for (const auto &levels : this->sbm_levels)
+        for (const auto &matrix : levels)
+            bytes += matrix.capacity() * sizeof(Count);
+    return bytes;
+}
+
+
+// Raise the sampling-level until the tracked state fits into the budget.
+//      The remaining nodes are renumbered, so all per-node containers stay dense.
+void InputModel::enforce_memory_budget() {
+    this->reads_since_check = 0;
+    while (this->tracked_bytes() > this->memory_budget && this->sample_level < 63) {
+        ++this->sample_level;
+
+        std::vector<Index> new_index(this->node_type_of.size(), -1);
+        StringMap<Index> kept;
+        for (auto it = this->node_ids.begin(); it != this->node_ids.end();) {
+            auto current = it++;
+            if (sample_level_of(current->first) < this->sample_level) {
+                if (current->first.size() >= sizeof(std::string))
+                    this->long_id_bytes -= current->first.size() + 1;
+                continue;
+            }
+            auto node = this->node_ids.extract(current);
+            new_index[node.mapped()] = static_cast<Index>(kept.size());
+            node.mapped() = static_cast<Index>(kept.size());
+            kept.insert(std::move(node));
+        }
+        this->node_ids = std::move(kept);
+
+        std::unordered_map<NodeID, Index> kept_numeric;
+        for (const auto &[node, idx] : this->numeric_node_ids) {
+            if (sample_level_of(node) < this->sample_level) { continue; }
+            new_index[idx] = static_cast<Index>(this->node_ids.size() + kept_numeric.size());
+            kept_numeric.emplace(node, new_index[idx]);
+        }
+        this->numeric_node_ids = std::move(kept_numeric);
+
+        std::vector<Index> types_kept(this->node_ids.size() + this->numeric_node_ids.size());
+        for (size_t old = 0; old < new_index.size(); ++old)
+            if (new_index[old] >= 0)
+                types_kept[new_index[old]] = this->node_type_of[old];
+        this->node_type_of = std::move(types_kept);
+
+        for (auto *degrees : {&this->in_degrees, &this->out_degrees}) {
+            for (auto &counters : *degrees) {
+                std::vector<Count> kept_counters(this->node_type_of.size(), 0);
+                for (size_t old = 0; old < counters.size(); ++old)
+                    if (new_index[old] >= 0)
+                        kept_counters[new_index[old]] = counters[old];
+                counters = std::move(kept_counters);
+            }
+        }
+
+        for (auto &levels : this->sbm_levels)
+            std::vector<Count>().swap(levels[this->sample_level - 1]);
+    }
 }
 
 
 void InputModel::preprocess() {
-    // Clear the data-structures, if it was previously preprocessed
-    if (this->is_preprocessed) {
-        this->in_distribution.clear();
-        this->out_distribution.clear();
+    // The per-node counters are released below, so the model can only be preprocessed once.
+    if (this->is_preprocessed)
+        return;
+
+    const Index nbr_types = this->types.size();
+    const Index nbr_colors = this->colors.size();
+    this->in_distribution.assign(nbr_types, std::vector<DegreeHistogram>(nbr_colors));
+    this->out_distribution.assign(nbr_types, std::vector<DegreeHistogram>(nbr_colors));
+
+    // Approximate ingestion: Every sampled node stands for 2^level nodes, every sampled transition for 4^level.
+    const long double node_weight = std::ldexp(1.0L, this->sample_level);
+    std::vector<Count> sampled_transitions(nbr_colors, 0);
+    if (this->memory_budget > 0) {
+        this->enforce_memory_budget();
+        for (Index color = 0; color < nbr_colors; ++color) {
+            this->sbm_matrix[color].assign(nbr_types * nbr_types, 0);
+            for (int level = this->sample_level; level < 64; ++level) {
+                const std::vector<Count> &matrix = this->sbm_levels[color][level];
+                for (size_t i = 0; i < matrix.size(); ++i) {
+                    sampled_transitions[color] += matrix[i];
+                    this->sbm_matrix[color][i] += std::llround(matrix[i] * node_weight * node_weight);
+                }
+            }
+        }
     }
+    std::vector<Count> sampled_nodes(2 * nbr_colors, std::numeric_limits<Count>::max());
 
     // Data is processed (pivoted) into a container more suitable for further use.
-    for (const auto &[color, nodes]: this->in_degrees)
-        for (const auto &[id, count]: nodes)
-            this->in_distribution[this->nodes_to_types[id]][color][count]++;
-
-    for (const auto &[color, nodes]: this->out_degrees)
-        for (const auto &[id, count]: nodes)
-            this->out_distribution[this->nodes_to_types[id]][color][count]++;
-
-
-    // Pad the containers with zero-degree nodes, if other degrees exist.
-    for (const auto &[ntype, container]: this->in_distribution) {
-        for (const auto &[color, buckets]: container) {
-            if (!buckets.empty()) {
-                // Count the number of nodes with associated degrees
-                long long node_sum = 0;
-                for (const auto &[_, count]: buckets)
-                    node_sum += count;
-
-                // The number of nodes with 0-degree is the number of nodes in the type, minus nodes with other degrees
-                this->in_distribution[ntype][color][0] = this->node_types[ntype] - node_sum;
+    //      Every color and direction is independent and only writes its own histograms.
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (Index task = 0; task < 2 * nbr_colors; ++task) {
+        const Index color = task / 2;
+        const bool incoming = (task % 2 == 0);
+        std::vector<Count> &degrees = incoming ? this->in_degrees[color] : this->out_degrees[color];
+        auto &distribution = incoming ? this->in_distribution : this->out_distribution;
+
+        std::vector<std::unordered_map<Degree, Count> > buckets(nbr_types);
+        for (size_t id = 0; id < degrees.size(); ++id)
+            if (degrees[id] > 0)
+                ++buckets[this->node_type_of[id]][degrees[id]];
+
+        // The counters of this color are not needed anymore.
+        std::vector<Count>().swap(degrees);
+
+        for (Index ntype = 0; ntype < nbr_types; ++ntype) {
+            if (buckets[ntype].empty()) { continue; }
+
+            DegreeHistogram &histogram = distribution[ntype][color];
+            histogram.assign(buckets[ntype].begin(), buckets[ntype].end());
+            std::sort(histogram.begin(), histogram.end());
+
+            // Pad the histogram with zero-degree nodes:
+            //      This is the number of nodes in the type, minus nodes with other degrees
+            //      Sampled counts are scaled up first, which may overestimate the number of nodes with edges.
+            Count node_sum = 0;
+            Count sampled_sum = 0;
+            for (auto &[_, count]: histogram) {
+                sampled_sum += count;
+                if (this->sample_level > 0)
+                    count = std::llround(count * node_weight);
+                node_sum += count;
             }
+            sampled_nodes[task] = std::min(sampled_nodes[task], sampled_sum);
+            histogram.insert(histogram.begin(),
+                             std::make_pair(0, std::max<Count>(0, this->node_types[ntype] - node_sum)));
         }
     }
-    for (const auto &[ntype, container]: this->out_distribution) {
-        for (const auto &[color, buckets]: container) {
-            if (!buckets.empty()) {
-                // Count the number of nodes with associated degrees
-                long long node_sum = 0;
-                for (const auto &[_, count]: buckets)
-                    node_sum += count;
 
-                // The number of nodes with 0-degree is the number of nodes in the type, minus nodes with other degrees
-                this->out_distribution[ntype][color][0] = this->node_types[ntype] - node_sum;
-            }
+    // Approximate ingestion: Colors without a single sampled transition fall back to independent types of the
+    //      endpoints, weighted by the sum of the (estimated) degrees of every type.
+    Count fallback_colors = 0;
+    for (Index color = 0; color < nbr_colors && this->memory_budget > 0; ++color) {
+        if (sampled_transitions[color] > 0) { continue; }
+        sampled_transitions[color] = std::numeric_limits<Count>::max();
+        ++fallback_colors;
+
+        std::vector<long double> out_weight(nbr_types, 0);
+        std::vector<long double> in_weight(nbr_types, 0);
+        long double out_sum = 0;
+        long double in_sum = 0;
+        for (Index ntype = 0; ntype < nbr_types; ++ntype) {
+            for (const auto &[degree, count] : this->out_distribution[ntype][color])
+                out_weight[ntype] += static_cast<long double>(degree) * count;
+            for (const auto &[degree, count] : this->in_distribution[ntype][color])
+                in_weight[ntype] += static_cast<long double>(degree) * count;
+            out_sum += out_weight[ntype];
+            in_sum += in_weight[ntype];
         }
+        for (Index s = 0; s < nbr_types && out_sum > 0 && in_sum > 0; ++s)
+            for (Index e = 0; e < nbr_types; ++e)
+                this->sbm_matrix[color][s * nbr_types + e] =
+                    std::llround(this->edge_count[color] * (out_weight[s] / out_sum) * (in_weight[e] / in_sum));
+    }
+
+    if (this->memory_budget > 0) {
+        // Relative error-bounds (95%, normal approximation) of the estimated counts: A count estimated from n samples,
+        //      each kept with probability q, has the relative standard-error sqrt((1-q)/n).
+        //      The bounds are reported for the smallest sample over all histograms/colors, i.e. the worst case.
+        const double q = 1.0 / static_cast<double>(node_weight);
+        const Count min_nodes = *std::min_element(sampled_nodes.begin(), sampled_nodes.end());
+        Count min_transitions = *std::min_element(sampled_transitions.begin(), sampled_transitions.end());
+        if (min_transitions == std::numeric_limits<Count>::max()) { min_transitions = 0; }
+        auto bound = [](const double keep, const Count samples) {
+            return samples > 0 ? 196.0 * std::sqrt((1.0 - keep) / static_cast<double>(samples)) : 100.0;
+        };
+        std::cout << "[INFO] Approximate ingestion kept 1/" << static_cast<double>(node_weight) << " of all nodes ("
+                  << this->node_type_of.size() << " nodes, ~" << this->tracked_bytes() / (1024 * 1024) << " MiB)." << std::endl
+                  << "\tThe nodes with edges per type and color are accurate to +-"
+                  << bound(q, min_nodes == std::numeric_limits<Count>::max() ? 0 : min_nodes) << "%," << std::endl
+                  << "\tthe type-transitions per color to +-" << bound(q * q, min_transitions) << "%"
+                  << " (95%-bounds, worst case)." << std::endl;
+        if (fallback_colors > 0)
+            std::cout << "\t" << fallback_colors << " color(s) had no sampled transition, their types are assumed"
+                      << " to be independent. Increase INGEST_MEMORY_BUDGET for a better estimate." << std::endl;
     }
 
+    // Release the remaining per-node state. Only the (much smaller) histograms are needed from here on.
+    StringMap<Index>().swap(this->node_ids);
+    std::vector<Index>().swap(this->dense_node_ids);
+    std::unordered_map<NodeID, Index>().swap(this->numeric_node_ids);
+    std::vector<Index>().swap(this->node_type_of);
+    std::vector<std::vector<Count> >().swap(this->in_degrees);
+    std::vector<std::vector<Count> >().swap(this->out_degrees);
+    std::vector<std::vector<std::vector<Count> > >().swap(this->sbm_levels);
+
     this->is_preprocessed = true;
 }
 
@@ -94,7 +626,43 @@ bool InputModel::save(const std::string &filepath) {
         this->preprocess();
     }
 
-    // TODO: Serialization
+    // See the loading constructor for the layout of the file.
+    try {
+        BinaryOut out(filepath);
+        out.put<uint64_t>(SNAPSHOT_MAGIC);
+        out.put<uint64_t>(SNAPSHOT_VERSION);
+
+        out.put<Count>(this->node_count);
+        out.put<uint64_t>(this->types.size());
+        out.put<uint64_t>(this->colors.size());
+        for (Index t = 0; t < this->types.size(); ++t)
+            out.put_string(this->types.name(t));
+        for (Index c = 0; c < this->colors.size(); ++c)
+            out.put_string(this->colors.name(c));
+
+        out.put_array<Count>(this->node_types);
+        out.put_array<Count>(this->edge_count);
+        for (const auto &matrix : this->sbm_matrix)
+            out.put_array<Count>(matrix);
+
+        std::vector<Count> flat;
+        for (const auto *distribution : {&this->in_distribution, &this->out_distribution}) {
+            for (const auto &per_type : *distribution) {
+                for (const auto &histogram : per_type) {
+                    flat.clear();
+                    for (const auto &[degree, count] : histogram) {
+                        flat.push_back(degree);
+                        flat.push_back(count);
+                    }
+                    out.put_array<Count>(flat);
+                }
+            }
+        }
+        out.close();
+    } catch (const std::exception &e) {
+        std::cerr << "[WARNING] Could not save the model snapshot: " << e.what() << std::endl;
+        return false;
+    }
 
-    return false;
+    return true;
 }
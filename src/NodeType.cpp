@@ -1,23 +1,23 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <stdexcept>
 
 #include "GraphGenTypes.h"
+#include "BinaryIO.h"
 #include "Prime.cpp"
 
 
 NodeType::NodeType(const std::string& name, const Number offset, const Number nodeCount,
                    std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count>>> in_degrees,
-                   std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count>>> out_degrees)
+                   std::unordered_map<Edgecolor, std::vector<std::pair<Degree, Count>>> out_degrees,
+                   const uint64_t seed)
 {
     // Set object attributes
     this->offset = offset;
     this->type_name = name;
     this->size = nodeCount;
 
-    // Initialize Randomness
-    this->rdm_gen = std::mt19937(std::random_device{}());
-
     // Find the first prime number larger than the number of Elements
     this->p = this->size;
     while (!is_prime(this->p))
@@ -93,15 +93,15 @@ NodeType::NodeType(const std::string& name, const Number offset, const Number no
 
             // Calculate the probabilities and transfer them to new base-vectors for the Alias-Table.
             // Pre-Initialize Uniform_Distributions in the desired range
-            std::vector<std::pair<probability, std::uniform_int_distribution<NodeID>>> in_probabilities;
-            std::vector<std::pair<probability, std::uniform_int_distribution<NodeID>>> out_probabilities;
+            std::vector<std::pair<probability, IdRange>> in_probabilities;
+            std::vector<std::pair<probability, IdRange>> out_probabilities;
 
             Number lower_bound = 0;
             for (const auto& [degree, element_count] : in)
             {
                 auto prob = static_cast<double>((degree*element_count) / static_cast<long double>(weighted_sum_in));
                 Number upper_bound = lower_bound + (element_count-1);
-                in_probabilities.emplace_back(prob, std::uniform_int_distribution<NodeID>(lower_bound, upper_bound));
+                in_probabilities.emplace_back(prob, IdRange{lower_bound, upper_bound});
                 lower_bound = upper_bound + 1;
             }
 
@@ -110,7 +110,7 @@ NodeType::NodeType(const std::string& name, const Number offset, const Number no
             {
                 auto prob = static_cast<double>((degree*element_count) / static_cast<long double>(weighted_sum_out));
                 Number upper_bound = lower_bound + (element_count-1);
-                out_probabilities.emplace_back(prob, std::uniform_int_distribution<NodeID>(lower_bound, upper_bound));
+                out_probabilities.emplace_back(prob, IdRange{lower_bound, upper_bound});
                 lower_bound = upper_bound + 1;
             }
 
@@ -118,52 +118,83 @@ NodeType::NodeType(const std::string& name, const Number offset, const Number no
             this->in_distribution[color] = AliasTable(in_probabilities);
             this->out_distribution[color] = AliasTable(out_probabilities);
 
-        // Draw a random a,b-Hash Function
-        Number a = std::uniform_int_distribution<Number>(1, p-1)(this->rdm_gen);
-        Number b = std::uniform_int_distribution<Number>(0, p-1)(this->rdm_gen);
+        // Draw a random a,b-Hash Function. The stream only depends on the seed, the type and the color.
+        CounterRng rng(derive_key(derive_key(seed, hash_name(name)), hash_name(color)));
+        Number a = 1 + static_cast<Number>(rng.below(p - 1));
+        Number b = static_cast<Number>(rng.below(p));
         this->hash_a_b[color] = std::make_pair(a, b);
     }
 }
 
 
-NodeID NodeType::get_start_node(const Edgecolor& color){
-    NodeID nodeid;
-    Number a = this->hash_a_b[color].first;
-    Number b = this->hash_a_b[color].second;
+// Load a NodeType written by NodeType::save(). The alias-tables are used in place from the file.
+NodeType::NodeType(BinaryIn &in)
+{
+    this->type_name = in.get_string();
+    this->offset = in.get<Number>();
+    this->size = in.get<Number>();
+    this->p = in.get<Number>();
 
-    while (true)
+    const auto nbr_colors = in.get<uint64_t>();
+    for (uint64_t i = 0; i < nbr_colors; i++)
     {
-        // Roll a range of IDs, pick one ID at uniform from that range
-        nodeid = this->out_distribution[color].getElement()(this->rdm_gen);
+        const Edgecolor color = in.get_string();
+        const auto a = in.get<Number>();
+        const auto b = in.get<Number>();
+        this->hash_a_b[color] = std::make_pair(a, b);
+        this->in_distribution[color] = load_alias_table<IdRange>(in);
+        this->out_distribution[color] = load_alias_table<IdRange>(in);
+    }
+}
+
 
-        // Apply the Permutation-Function (a,b)-Hash to the id
-        nodeid = (a*nodeid + b) % this->p;
+// Write the scaled and padded tables, so the NodeType can be restored without any preprocessing.
+void NodeType::save(BinaryOut &out) const
+{
+    out.put_string(this->type_name);
+    out.put<Number>(this->offset);
+    out.put<Number>(this->size);
+    out.put<Number>(this->p);
 
-        // Reroll any ids from the "Overflow-Range" [size, p]
-        if (nodeid < this->size)
-            return this->offset + nodeid;
+    out.put<uint64_t>(this->hash_a_b.size());
+    for (const auto& [color, a_b] : this->hash_a_b)
+    {
+        out.put_string(color);
+        out.put<Number>(a_b.first);
+        out.put<Number>(a_b.second);
+        save_alias_table(out, this->in_distribution.at(color));
+        save_alias_table(out, this->out_distribution.at(color));
     }
 }
 
-NodeID NodeType::get_target_node(const Edgecolor& color){
-    Number a = this->hash_a_b[color].first;
-    Number b = this->hash_a_b[color].second;
 
-    while (true)
-    {
-        // Roll a range of IDs, pick one ID at uniform from that range
-        NodeID nodeid = this->in_distribution[color].getElement()(this->rdm_gen);
+NodeID NodeType::get_start_node(const Edgecolor& color, CounterRng &rng) const{
+    return this->get_start_sampler(color).draw(rng);
+}
 
-        // Apply the Permutation-Function (a,b)-Hash to the id
-        nodeid = (a*nodeid + b) % this->p;
+NodeID NodeType::get_target_node(const Edgecolor& color, CounterRng &rng) const{
+    return this->get_target_sampler(color).draw(rng);
+}
 
-        // Reroll any ids from the "Overflow-Range" [size, p]
-        if (nodeid < this->size)
-            return this->offset + nodeid;
-    }
+NodeSampler NodeType::get_start_sampler(const Edgecolor& color) const{
+    const auto it = this->hash_a_b.find(color);
+    if (it == this->hash_a_b.end())
+        throw std::out_of_range("Node-Type '" + this->type_name + "' has no edges of the color '" + color + "'.");
+
+    const auto [a, b] = it->second;
+    return NodeSampler{&this->out_distribution.at(color), a, b, this->p, this->offset, this->size};
+}
+
+NodeSampler NodeType::get_target_sampler(const Edgecolor& color) const{
+    const auto it = this->hash_a_b.find(color);
+    if (it == this->hash_a_b.end())
+        throw std::out_of_range("Node-Type '" + this->type_name + "' has no edges of the color '" + color + "'.");
+
+    const auto [a, b] = it->second;
+    return NodeSampler{&this->in_distribution.at(color), a, b, this->p, this->offset, this->size};
 }
 
-std::string NodeType::get_type_name(){
+const std::string &NodeType::get_type_name() const{
     return this->type_name;
 }
 
@@ -1,13 +1,35 @@
 #include <cmath>
+#include <cstdint>
+
+
+// (a * b) mod m without overflow, for any 64-bit operands.
+inline uint64_t mul_mod(const uint64_t a, const uint64_t b, const uint64_t m) {
+    __extension__ typedef unsigned __int128 uint128;
+    return static_cast<uint64_t>(static_cast<uint128>(a) * b % m);
+}
+
+
+// (base ^ exponent) mod m by repeated squaring.
+inline uint64_t pow_mod(uint64_t base, uint64_t exponent, const uint64_t m) {
+    uint64_t result = 1;
+    base %= m;
+    while (exponent > 0) {
+        if (exponent & 1)
+            result = mul_mod(result, base, m);
+        base = mul_mod(base, base, m);
+        exponent >>= 1;
+    }
+    return result;
+}
 
 
 // Naive primality-Testing for n>2 in O(sqrt(n))
-inline bool naive_prime(const int n) {
+inline bool naive_prime(const long long n) {
     if (n % 2 == 0)
         return false;
 
-    int divisor = 3;
-    const int target = std::ceil(std::sqrt(n));
+    long long divisor = 3;
+    const auto target = static_cast<long long>(std::ceil(std::sqrt(static_cast<long double>(n))));
     while (divisor <= target)
     {
         if (n % divisor == 0) {
@@ -20,16 +42,43 @@ inline bool naive_prime(const int n) {
 }
 
 
-// Miller-Rabin Primality Test
-// Stochastic-Test with Failure-Probability < 1/2 ^ Iterations
-inline bool miller_rabin(int n, int iterations) {
-    throw; // Not yet implemented.
+// Miller-Rabin Primality Test for odd n > 2
+// Deterministic for all 64-bit numbers: No composite below 2^64 is a strong pseudoprime to all of the seven bases
+//      found by J. Sinclair (see https://miller-rabin.appspot.com).
+inline bool miller_rabin(const uint64_t n) {
+    // n - 1 = d * 2^s with odd d
+    uint64_t d = n - 1;
+    int s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        ++s;
+    }
+
+    constexpr uint64_t bases[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+    for (const uint64_t base : bases) {
+        const uint64_t a = base % n;
+        if (a == 0) { continue; }
+
+        uint64_t x = pow_mod(a, d, n);
+        if (x == 1 || x == n - 1) { continue; }
+
+        bool witness = true;
+        for (int r = 1; r < s && witness; ++r) {
+            x = mul_mod(x, x, n);
+            witness = x != n - 1;
+        }
+        if (witness)
+            return false;
+    }
     return true;
 }
 
 
-inline bool is_prime(const int n) {
+inline bool is_prime(const long long n) {
     if (n <= 1) return false;
     if (n == 2) return true;
-    return naive_prime(n);
-}
\ No newline at end of file
+    // Trial division is faster for small numbers, Miller-Rabin needs O(log n) multiplications for any n.
+    if (n < 1000000) return naive_prime(n);
+    if (n % 2 == 0) return false;
+    return miller_rabin(static_cast<uint64_t>(n));
+}
@@ -1,8 +1,24 @@
 #include "GraphGenTypes.h"
+#include "MappedFile.h"
+#include "BinaryIO.h"
+#include "BinaryGraph.h"
+#include "Compression.h"
 
+#include <array>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 
 GraphReader::GraphReader(const std::vector<std::string> &nodefile_paths,
@@ -17,6 +33,18 @@ void GraphReader::readTo(InputModel& model){}
 
 
 
+// The line-by-line reader only supports plain text. Compressed inputs are read by the ParallelTSVReader.
+static void reject_compressed(const std::string &filename) {
+    std::ifstream probe(filename, std::ifstream::binary);
+    char magic[4] = {};
+    probe.read(magic, sizeof(magic));
+    const Compression compression = detect_compression(std::string_view(magic, probe.gcount()));
+    if (compression != Compression::NONE)
+        throw std::runtime_error("\tThe file '" + filename + "' is " + compression_name(compression) + "-compressed. "
+                                 "Use READER_TYPE=PARALLEL_TSV to read compressed files.");
+}
+
+
 void TSVReader::readTo(InputModel& model){
     // Read all Nodefiles
     std::cout << "\tReading Nodes..." << std::endl;
@@ -24,6 +52,7 @@ void TSVReader::readTo(InputModel& model){
     {
         // Every File is parsed Line-By-Line
         if (std::ifstream file(filename); file.is_open()) {
+            reject_compressed(filename);
             std::filesystem::path path{filename};
             std::cout << "\t\tReading \"" << path.string() << "\" (" << std::filesystem::file_size(path) << "bytes)" << std::endl;
             long long nodecount = 0;
@@ -38,8 +67,9 @@ void TSVReader::readTo(InputModel& model){
                 if (p2 == std::string::npos){std::cout << "\t\tSkipping invalid line: '" << line << "'" << std::endl; continue;}
 
                 // Split the string on tabs, read the first and second component
-                std::string     id    = line.substr(0, p1);
-                Nodetype        nType = line.substr(p1+1, p2-(p1+1));
+                const std::string_view view  = line;
+                const std::string_view id    = view.substr(0, p1);
+                const std::string_view nType = view.substr(p1+1, p2-(p1+1));
                 model.readNode(id, nType);
                 ++nodecount;
             }
@@ -57,6 +87,7 @@ void TSVReader::readTo(InputModel& model){
     {
         std::ifstream file(filename);
         if (file.is_open()) {
+            reject_compressed(filename);
             std::filesystem::path path{filename};
             std::cout << "\t\tReading \"" << path.string() << "\" (" << std::filesystem::file_size(path) << "bytes)" << std::endl;
             long long edgecount = 0;
@@ -75,9 +106,10 @@ void TSVReader::readTo(InputModel& model){
 
                 // Split the string on tabs, read the first and second component as IDs,
                 //      the third component as the color of the edge.
-                std::string     start = line.substr(0, p1);
-                std::string     end   = line.substr(p1+1, p2-(p1+1));
-                Edgecolor       color = line.substr(p2+1, p3-(p2+1));
+                const std::string_view view  = line;
+                const std::string_view start = view.substr(0, p1);
+                const std::string_view end   = view.substr(p1+1, p2-(p1+1));
+                const std::string_view color = view.substr(p2+1, p3-(p2+1));
 
                 model.readEdge(start, end, color);
                 ++edgecount;
@@ -88,4 +120,387 @@ void TSVReader::readTo(InputModel& model){
             throw std::runtime_error("\tError opening nodefile '" + filename + "'.");
         }
     }
-}
\ No newline at end of file
+}
+
+
+
+
+// Size of the newline-aligned chunks the ParallelTSVReader splits its inputs into.
+// Large enough to amortize the scheduling, small enough to keep all threads busy on a single file.
+constexpr size_t PARALLEL_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// A newline-aligned slice of one input file.
+// Chunks of compressed files own their decompressed text, chunks of plain files point into the memory-mapping.
+struct TextChunk {
+    std::string_view text;
+    // Index of the file in the list of read files.
+    size_t file;
+    std::shared_ptr<const std::string> owner;
+};
+
+
+// Split the given file-content into chunks of roughly PARALLEL_CHUNK_SIZE bytes, each ending on a line-break.
+// The first line of every file defines the structure of the file and is skipped.
+static void split_into_chunks(std::string_view content, const size_t file, std::vector<TextChunk> &chunks) {
+    size_t pos = content.find('\n');
+    pos = (pos == std::string_view::npos) ? content.size() : pos + 1;
+
+    while (pos < content.size()) {
+        size_t end = std::min(pos + PARALLEL_CHUNK_SIZE, content.size());
+        if (end < content.size()) {
+            end = content.find('\n', end);
+            end = (end == std::string_view::npos) ? content.size() : end + 1;
+        }
+        chunks.push_back(TextChunk{content.substr(pos, end - pos), file, nullptr});
+        pos = end;
+    }
+}
+
+
+// Bounded queue between a decompressing thread and the parsing threads.
+// The capacity limits the amount of decompressed text held in memory at any time.
+class ChunkQueue {
+public:
+    explicit ChunkQueue(const size_t capacity) : capacity(capacity) {}
+
+    // Wait for free space and append the chunk. Returns false, if the consumer has aborted the reading.
+    bool push(std::shared_ptr<const std::string> chunk) {
+        std::unique_lock lock(this->mutex);
+        this->not_full.wait(lock, [this] { return this->aborted || this->chunks.size() < this->capacity; });
+        if (this->aborted)
+            return false;
+        this->chunks.push_back(std::move(chunk));
+        this->not_empty.notify_one();
+        return true;
+    }
+
+    // Mark the end of the stream. An exception of the producer is rethrown to the consumer.
+    void close(std::exception_ptr failure = nullptr) {
+        std::lock_guard lock(this->mutex);
+        this->closed = true;
+        this->error = std::move(failure);
+        this->not_empty.notify_all();
+    }
+
+    // Wait for the next chunk. Returns nullptr at the end of the stream.
+    std::shared_ptr<const std::string> pop() {
+        std::unique_lock lock(this->mutex);
+        this->not_empty.wait(lock, [this] { return this->closed || !this->chunks.empty(); });
+        if (this->chunks.empty()) {
+            if (this->error)
+                std::rethrow_exception(this->error);
+            return nullptr;
+        }
+        std::shared_ptr<const std::string> chunk = std::move(this->chunks.front());
+        this->chunks.pop_front();
+        this->not_full.notify_one();
+        return chunk;
+    }
+
+    void abort() {
+        std::lock_guard lock(this->mutex);
+        this->aborted = true;
+        this->not_full.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<std::shared_ptr<const std::string> > chunks;
+    size_t capacity;
+    bool closed = false;
+    bool aborted = false;
+    std::exception_ptr error;
+};
+
+
+// Newline-aligned chunks of a single memory-mapped input file, skipping the header line.
+// Compressed files are decompressed by a background thread while the previous chunks are parsed.
+class ChunkSource {
+public:
+    ChunkSource(const MappedFile &file, const size_t file_index, const Compression compression,
+                const size_t queue_capacity) : file_index(file_index), queue(queue_capacity) {
+        if (compression == Compression::NONE) {
+            split_into_chunks(file.view(), file_index, this->plain);
+            return;
+        }
+        // Created here, so a missing library is reported before any thread is started.
+        std::shared_ptr<Decompressor> decompressor = Decompressor::create(compression, file.view());
+        this->worker = std::thread([this, decompressor] {
+            try {
+                this->decompress(*decompressor);
+                this->queue.close();
+            } catch (...) {
+                this->queue.close(std::current_exception());
+            }
+        });
+    }
+
+    ChunkSource(const ChunkSource &) = delete;
+    ChunkSource &operator=(const ChunkSource &) = delete;
+
+    // Stops the decompression, if the reading has been aborted by an exception.
+    ~ChunkSource() {
+        if (this->worker.joinable()) {
+            this->queue.abort();
+            this->worker.join();
+        }
+    }
+
+    // The next (up to) max_chunks chunks of the file. Empty at the end of the file.
+    std::vector<TextChunk> next_batch(const size_t max_chunks) {
+        if (!this->worker.joinable())
+            return std::exchange(this->plain, {});
+
+        std::vector<TextChunk> batch;
+        while (batch.size() < max_chunks) {
+            std::shared_ptr<const std::string> chunk = this->queue.pop();
+            if (!chunk)
+                break;
+            batch.push_back(TextChunk{*chunk, this->file_index, chunk});
+        }
+        return batch;
+    }
+
+private:
+    void decompress(Decompressor &decompressor) {
+        std::string pending;
+        bool in_header = true;
+        while (true) {
+            const size_t old_size = pending.size();
+            pending.resize(old_size + PARALLEL_CHUNK_SIZE);
+            const size_t n = decompressor.read(pending.data() + old_size, PARALLEL_CHUNK_SIZE);
+            pending.resize(old_size + n);
+
+            if (in_header) {
+                const size_t eol = pending.find('\n');
+                if (eol == std::string::npos) {
+                    pending.clear();
+                    if (n == 0) return;
+                    continue;
+                }
+                pending.erase(0, eol + 1);
+                in_header = false;
+            }
+
+            if (n == 0) {
+                if (!pending.empty())
+                    this->queue.push(std::make_shared<const std::string>(std::move(pending)));
+                return;
+            }
+
+            // Only complete lines are passed on, the rest is kept for the next round.
+            const size_t eol = pending.rfind('\n');
+            if (eol == std::string::npos)
+                continue;
+            auto chunk = std::make_shared<const std::string>(pending, 0, eol + 1);
+            pending.erase(0, eol + 1);
+            if (!this->queue.push(std::move(chunk)))
+                return;
+        }
+    }
+
+    size_t file_index;
+    std::vector<TextChunk> plain;
+    ChunkQueue queue;
+    std::thread worker;
+};
+
+
+// Split every line of the chunk on tabs and collect the first N components.
+// Lines with less than N+1 components are invalid (see TSVReader) and collected separately.
+template<size_t N>
+static void tokenize_chunk(std::string_view text, std::vector<std::array<std::string_view, N> > &rows,
+                           std::vector<std::string_view> &invalid) {
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+
+        std::array<std::string_view, N> row;
+        size_t start = 0;
+        bool valid = true;
+        for (size_t i = 0; i < N; ++i) {
+            size_t tab = line.find('\t', start);
+            if (tab == std::string_view::npos) { valid = false; break; }
+            row[i] = line.substr(start, tab - start);
+            start = tab + 1;
+        }
+
+        if (valid)
+            rows.push_back(row);
+        else
+            invalid.push_back(line);
+    }
+}
+
+
+// Memory-map all given files, tokenize them in parallel and pass every row to read(chunk, row).
+// Every chunk is tokenized and interned by read() into its own InputChunk concurrently. Only the merging into the
+//      model, which assigns the global indices, runs in file/line order from one thread at a time.
+// gzip/zstd-compressed files are detected by their magic bytes and decompressed on the fly.
+// Up to one file per thread is open at once: The chunks of several small files are tokenized in the same parallel
+//      loop, and several compressed files are decompressed concurrently.
+template<size_t N, typename Read>
+static void read_parallel(const std::vector<std::string> &filenames, const std::string &what, InputModel &model,
+                          Read read) {
+#ifdef _OPENMP
+    const size_t threads = static_cast<size_t>(omp_get_max_threads());
+#else
+    const size_t threads = 1;
+#endif
+    // Chunks are tokenized in batches of a few chunks per thread. The decompressed chunks queued ahead of the batch
+    //      are shared by the open files.
+    const size_t batch_size = 4 * threads;
+    const size_t max_open = std::max<size_t>(threads, 1);
+    const size_t queue_capacity = std::max<size_t>(batch_size / max_open, 2);
+
+    struct OpenFile {
+        size_t index;
+        std::unique_ptr<MappedFile> file;
+        std::unique_ptr<ChunkSource> source;
+    };
+    std::deque<OpenFile> open;
+    size_t next_file = 0;
+    std::vector<long long> counts(filenames.size(), 0);
+
+    const auto open_next = [&] {
+        const std::string &filename = filenames[next_file];
+        OpenFile entry{next_file++, nullptr, nullptr};
+        try {
+            entry.file = std::make_unique<MappedFile>(filename);
+        } catch (const std::runtime_error &) {
+            throw std::runtime_error("\tError opening " + what + "-file '" + filename + "'.");
+        }
+        const Compression compression = detect_compression(entry.file->view());
+        std::cout << "\t\tReading \"" << filename << "\" (" << entry.file->size() << "bytes";
+        if (compression != Compression::NONE)
+            std::cout << ", " << compression_name(compression) << "-compressed";
+        std::cout << ")" << std::endl;
+        try {
+            entry.source = std::make_unique<ChunkSource>(*entry.file, entry.index, compression, queue_capacity);
+        } catch (const std::runtime_error &e) {
+            throw std::runtime_error("\tError reading " + what + "-file '" + filename + "': " + e.what());
+        }
+        open.push_back(std::move(entry));
+    };
+
+    while (true) {
+        while (open.size() < max_open && next_file < filenames.size())
+            open_next();
+        if (open.empty()) { break; }
+
+        // Take the chunks in file order. Finished files stay mapped until their chunks have been tokenized.
+        std::vector<TextChunk> chunks;
+        std::vector<OpenFile> finished;
+        while (chunks.size() < batch_size && !open.empty()) {
+            OpenFile &front = open.front();
+            std::vector<TextChunk> more;
+            try {
+                more = front.source->next_batch(batch_size - chunks.size());
+            } catch (const std::runtime_error &e) {
+                throw std::runtime_error("\tError reading " + what + "-file '" + filenames[front.index] + "': "
+                                         + e.what());
+            }
+            if (more.empty()) {
+                finished.push_back(std::move(front));
+                open.pop_front();
+                if (next_file < filenames.size())
+                    open_next();
+                continue;
+            }
+            chunks.insert(chunks.end(), std::make_move_iterator(more.begin()), std::make_move_iterator(more.end()));
+        }
+
+        #pragma omp parallel for ordered schedule(dynamic, 1)
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            std::vector<std::array<std::string_view, N> > rows;
+            std::vector<std::string_view> invalid;
+            tokenize_chunk<N>(chunks[c].text, rows, invalid);
+            InputChunk partial;
+            for (const auto &row : rows)
+                read(partial, row);
+
+            #pragma omp ordered
+            {
+                for (const std::string_view line : invalid)
+                    std::cout << "\t\tSkipping invalid line: '" << line << "'" << std::endl;
+                model.merge(partial);
+                counts[chunks[c].file] += static_cast<long long>(rows.size());
+            }
+        }
+
+        for (const OpenFile &entry : finished)
+            std::cout << "\t\tRead \"" << filenames[entry.index] << "\": " << counts[entry.index] << " " << what
+                      << "s." << std::endl;
+    }
+}
+
+
+void ParallelTSVReader::readTo(InputModel& model){
+    // Nodes need to be known before any edges are read, so the two groups of files are processed one after another.
+    std::cout << "\tReading Nodes..." << std::endl;
+    read_parallel<2>(this->nodefiles, "Node", model, [](InputChunk &chunk, const std::array<std::string_view, 2> &row) {
+        chunk.readNode(row[0], row[1]);
+    });
+
+    std::cout << "\tReading Edgefiles:" << std::endl;
+    read_parallel<3>(this->edgefiles, "Edge", model, [](InputChunk &chunk, const std::array<std::string_view, 3> &row) {
+        chunk.readEdge(row[0], row[1], row[2]);
+    });
+}
+
+
+
+
+// Open a binary graph file and read its header. Returns the model-indices of the types/colors named in the file.
+template<typename Intern>
+static std::vector<Index> read_binary_header(BinaryIn &in, const std::string &filename, const uint64_t magic,
+                                             const std::string &what, Intern intern) {
+    if (in.size() < sizeof(magic) || in.get<uint64_t>() != magic)
+        throw std::runtime_error("\t'" + filename + "' is not a binary " + what + "-file.");
+    if (const auto version = in.get<uint64_t>(); version != BINARY_GRAPH_VERSION)
+        throw std::runtime_error("\tBinary " + what + "-file '" + filename + "' has version " + std::to_string(version)
+                                 + ", but version " + std::to_string(BINARY_GRAPH_VERSION) + " is required.");
+
+    std::vector<Index> indices(in.get<uint64_t>());
+    for (Index &idx : indices)
+        idx = intern(in.get_string());
+    return indices;
+}
+
+
+void BinaryReader::readTo(InputModel& model){
+    std::cout << "\tReading Nodes..." << std::endl;
+    for (const std::string& filename : this->nodefiles) {
+        BinaryIn in(filename);
+        std::cout << "\t\tReading \"" << filename << "\" (" << in.size() << "bytes)" << std::endl;
+        const std::vector<Index> types = read_binary_header(in, filename, BINARY_NODES_MAGIC, "Node",
+            [&model](const std::string_view name) { return model.type_index(name); });
+
+        const std::span<const NodeRecord> records = in.view_array<NodeRecord>();
+        for (const NodeRecord &record : records) {
+            if (record.type >= types.size())
+                throw std::runtime_error("\tInvalid type " + std::to_string(record.type) + " in '" + filename + "'.");
+            model.readNode(static_cast<NodeID>(record.id), types[record.type]);
+        }
+        std::cout << "\t\tRead: " << records.size() << " Nodes." << std::endl;
+    }
+
+    std::cout << "\tReading Edgefiles:" << std::endl;
+    for (const std::string& filename : this->edgefiles) {
+        BinaryIn in(filename);
+        std::cout << "\t\tReading \"" << filename << "\" (" << in.size() << "bytes)" << std::endl;
+        const std::vector<Index> colors = read_binary_header(in, filename, BINARY_EDGES_MAGIC, "Edge",
+            [&model](const std::string_view name) { return model.color_index(name); });
+
+        const std::span<const EdgeRecord> records = in.view_array<EdgeRecord>();
+        for (const EdgeRecord &record : records) {
+            if (record.color >= colors.size())
+                throw std::runtime_error("\tInvalid color " + std::to_string(record.color) + " in '" + filename + "'.");
+            model.readEdge(static_cast<NodeID>(record.start), static_cast<NodeID>(record.end), colors[record.color]);
+        }
+        std::cout << "\t\tRead: " << records.size() << " Edges." << std::endl;
+    }
+}
@@ -0,0 +1,169 @@
+#include "SimpleGraph.h"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+
+// Edges are distributed to 2^PARTITION_BITS partitions by the upper bits of their hash.
+constexpr int PARTITION_BITS = 8;
+constexpr size_t PARTITIONS = size_t{1} << PARTITION_BITS;
+
+// Rejected edges are drawn again at most this often, e.g. if a color has fewer possible edges than requested.
+constexpr int MAX_ROUNDS = 64;
+
+
+static uint64_t edge_hash(const Edge &edge) {
+    return mix64(static_cast<uint64_t>(edge.start) * RNG_GAMMA ^ static_cast<uint64_t>(edge.end));
+}
+
+
+// An edge to check, together with its position. Partitions store copies, so they are checked with sequential reads.
+struct Candidate {
+    Edge edge;
+    Count pos;
+};
+
+
+// Hash-set of edges with open addressing (linear probing). Empty slots are marked by NO_EDGE.
+class EdgeSet {
+public:
+    // Insert the edge with the given hash. Returns false, if the edge is contained already.
+    bool insert(const Edge &edge, const uint64_t hash) {
+        if (2 * (this->count + 1) > this->slots.size())
+            this->grow();
+
+        const size_t mask = this->slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            Edge &slot = this->slots[i];
+            if (slot.start == NO_EDGE.start) {
+                slot = edge;
+                ++this->count;
+                return true;
+            }
+            if (slot.start == edge.start && slot.end == edge.end)
+                return false;
+        }
+    }
+
+    // Make room for the given number of edges without growing the table again.
+    void reserve(const size_t edges) {
+        size_t capacity = 16;
+        while (capacity < 2 * edges)
+            capacity *= 2;
+        if (capacity > this->slots.size())
+            this->grow(capacity);
+    }
+
+private:
+    std::vector<Edge> slots;
+    size_t count = 0;
+
+    void grow(const size_t capacity = 0) {
+        std::vector<Edge> old(std::max<size_t>({16, 2 * this->slots.size(), capacity}), NO_EDGE);
+        std::swap(old, this->slots);
+        this->count = 0;
+        for (const Edge &edge : old)
+            if (edge.start != NO_EDGE.start)
+                this->insert(edge, edge_hash(edge));
+    }
+};
+
+
+Count simple_buckets(const Count edges) {
+    return std::max<Count>((edges + SIMPLE_BUCKET_EDGES - 1) / SIMPLE_BUCKET_EDGES, 1);
+}
+
+// The mixed hash is mapped to [0, buckets) by a multiplication, no bits are lost to a modulo.
+Count simple_bucket(const NodeID start, const Count buckets) {
+    __extension__ typedef unsigned __int128 uint128;
+    const uint64_t hash = mix64(static_cast<uint64_t>(start) * RNG_GAMMA);
+    return static_cast<Count>((static_cast<uint128>(hash) * static_cast<uint64_t>(buckets)) >> 64);
+}
+
+
+SimpleGraphStats make_simple(std::vector<Edge> &edges, const uint64_t key,
+                             const std::function<NodeID(Count, CounterRng &)> &draw_end) {
+#ifdef _OPENMP
+    const size_t threads = static_cast<size_t>(omp_get_max_threads());
+#else
+    const size_t threads = 1;
+#endif
+    SimpleGraphStats stats;
+    std::vector<EdgeSet> sets(PARTITIONS);
+
+    // Positions of the edges to check, in ascending order. Initially all edges.
+    std::vector<Count> pending(edges.size());
+    for (size_t i = 0; i < pending.size(); ++i)
+        pending[i] = static_cast<Count>(i);
+
+    for (int round = 0; !pending.empty(); ++round) {
+        if (round == MAX_ROUNDS) {
+            for (const Count pos : pending)
+                edges[pos] = NO_EDGE;
+            stats.dropped = static_cast<Count>(pending.size());
+            break;
+        }
+
+        // Draw a replacement for every edge rejected in the previous round.
+        if (round > 0) {
+            const uint64_t round_key = derive_key(key, static_cast<uint64_t>(round));
+            #pragma omp parallel for schedule(static)
+            for (size_t i = 0; i < pending.size(); ++i) {
+                CounterRng rng(derive_key(round_key, static_cast<uint64_t>(pending[i])));
+                edges[pending[i]].end = draw_end(pending[i], rng);
+            }
+        }
+
+        // Distribute the positions to the partitions. The static schedule hands out contiguous ranges in the order of
+        //      the threads, so the positions of a partition are ascending when the lists are visited by thread.
+        std::vector<std::vector<std::vector<Candidate> > > scattered(
+            threads, std::vector<std::vector<Candidate> >(PARTITIONS));
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < pending.size(); ++i) {
+#ifdef _OPENMP
+            const auto thread = static_cast<size_t>(omp_get_thread_num());
+#else
+            const size_t thread = 0;
+#endif
+            const Edge &edge = edges[pending[i]];
+            scattered[thread][edge_hash(edge) >> (64 - PARTITION_BITS)].push_back(Candidate{edge, pending[i]});
+        }
+
+        // A partition receives about 1/PARTITIONS of the edges, plus a few percent for the hashing.
+        if (round == 0)
+            for (EdgeSet &set : sets)
+                set.reserve(pending.size() / PARTITIONS + pending.size() / PARTITIONS / 16);
+
+        // Check the edges of every partition in order of their positions.
+        std::vector<std::vector<Count> > rejected(PARTITIONS);
+        Count self_loops = 0;
+        Count duplicates = 0;
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+ : self_loops, duplicates)
+        for (size_t p = 0; p < PARTITIONS; ++p) {
+            for (size_t t = 0; t < threads; ++t) {
+                for (const auto &[edge, pos] : scattered[t][p]) {
+                    if (edge.start == edge.end) {
+                        ++self_loops;
+                        rejected[p].push_back(pos);
+                    } else if (!sets[p].insert(edge, edge_hash(edge))) {
+                        ++duplicates;
+                        rejected[p].push_back(pos);
+                    }
+                }
+                // Release the candidates as early as possible.
+                std::vector<Candidate>().swap(scattered[t][p]);
+            }
+        }
+        stats.self_loops += self_loops;
+        stats.duplicates += duplicates;
+
+        pending.clear();
+        for (const std::vector<Count> &positions : rejected)
+            pending.insert(pending.end(), positions.begin(), positions.end());
+        std::sort(pending.begin(), pending.end());
+    }
+    return stats;
+}
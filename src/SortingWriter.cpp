@@ -0,0 +1,355 @@
+#include "../include/GraphGenTypes.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+
+// Sorted edges are passed to the output in batches of this size.
+constexpr size_t MERGE_BATCH_SIZE = 1 << 16;
+
+// Parts sorted by a single thread have at least this size, smaller buffers are sorted by fewer threads.
+constexpr size_t MIN_PART_SIZE = 1 << 16;
+
+// Maximum number of spilled runs merged at once. More runs are merged in intermediate passes, so the read-buffers of
+//      the runs stay within the memory budget (at least MIN_PART_SIZE / MAX_MERGE_FANIN edges per run).
+constexpr size_t MAX_MERGE_FANIN = 16;
+
+
+static bool edge_less(const Edge &l, const Edge &r) {
+    return l.start < r.start || (l.start == r.start && l.end < r.end);
+}
+
+
+// Sort the edges in parallel. Every thread sorts a contiguous part, the sorted parts are returned as runs.
+//      std::threads are used, as the writer is called from within the parallel regions of the generator.
+static std::vector<std::span<const Edge> > sort_parts(std::vector<Edge> &edges) {
+#ifdef _OPENMP
+    const auto threads = static_cast<size_t>(omp_get_max_threads());
+#else
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    const size_t parts = std::clamp<size_t>(edges.size() / MIN_PART_SIZE, 1, threads);
+
+    std::vector<std::span<const Edge> > runs;
+    std::vector<std::thread> workers;
+    for (size_t p = 0; p < parts; ++p) {
+        const auto first = edges.begin() + static_cast<std::ptrdiff_t>(edges.size() * p / parts);
+        const auto last = edges.begin() + static_cast<std::ptrdiff_t>(edges.size() * (p + 1) / parts);
+        runs.emplace_back(first, last);
+        workers.emplace_back([first, last] { std::sort(first, last, edge_less); });
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+    return runs;
+}
+
+
+// Sequential access to a sorted run, either in memory or buffered from a range of a spill-file.
+// The cursors of a merge share one stream of the spill-file, every refill seeks to the next part of its run.
+class RunCursor {
+public:
+    explicit RunCursor(const std::span<const Edge> edges) : view(edges) {}
+
+    RunCursor(std::ifstream &file, const uint64_t offset, const uint64_t length, const size_t buffer_size)
+        : file(&file), next(offset), remaining(length), buffer(std::max<size_t>(buffer_size, 1)) {
+        this->refill();
+    }
+
+    bool empty() const { return this->pos == this->view.size(); }
+
+    const Edge &front() const { return this->view[this->pos]; }
+
+    void pop() {
+        if (++this->pos == this->view.size() && this->remaining > 0)
+            this->refill();
+    }
+
+private:
+    std::span<const Edge> view;
+    size_t pos = 0;
+
+    std::ifstream *file = nullptr;
+    uint64_t next = 0;
+    uint64_t remaining = 0;
+    std::vector<Edge> buffer;
+
+    void refill() {
+        const size_t n = std::min<uint64_t>(this->remaining, this->buffer.size());
+        this->file->seekg(static_cast<std::streamoff>(this->next * sizeof(Edge)));
+        if (!this->file->read(reinterpret_cast<char *>(this->buffer.data()), static_cast<std::streamsize>(n * sizeof(Edge))))
+            throw std::runtime_error("Could not read a sorted run from the spill-file. Is the disk full?");
+        this->view = std::span<const Edge>(this->buffer.data(), n);
+        this->pos = 0;
+        this->next += n;
+        this->remaining -= n;
+    }
+};
+
+
+// k-way merge of the cursors with a min-heap, ordered by their first edge.
+//      The merged edges are passed to the sink in batches of up to MERGE_BATCH_SIZE edges.
+template<typename Sink>
+static void merge_runs(std::vector<RunCursor> &cursors, Sink sink) {
+    const auto heap_order = [&cursors](const size_t l, const size_t r) {
+        return edge_less(cursors[r].front(), cursors[l].front());
+    };
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < cursors.size(); ++i)
+        if (!cursors[i].empty())
+            heap.push_back(i);
+    std::make_heap(heap.begin(), heap.end(), heap_order);
+
+    std::vector<Edge> merged;
+    merged.reserve(MERGE_BATCH_SIZE);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), heap_order);
+        RunCursor &cursor = cursors[heap.back()];
+        merged.push_back(cursor.front());
+        cursor.pop();
+        if (cursor.empty())
+            heap.pop_back();
+        else
+            std::push_heap(heap.begin(), heap.end(), heap_order);
+
+        if (merged.size() == MERGE_BATCH_SIZE || heap.empty()) {
+            sink(std::as_const(merged));
+            merged.clear();
+        }
+    }
+}
+
+
+// Intermediate merge passes write to a second file next to the spill-file, which replaces it afterwards.
+static std::string merge_path(const std::string &spill_path) {
+    return spill_path + ".merge";
+}
+
+
+
+
+SortingWriter::SortingWriter(std::unique_ptr<GraphWriter> output, const size_t memory_budget_bytes,
+                             const std::string &spill_directory) : output(std::move(output)) {
+    // The buffer and the one being spilled share the memory budget.
+    this->buffer_capacity = std::max<size_t>(memory_budget_bytes / sizeof(Edge) / 2, MIN_PART_SIZE);
+    this->spill_directory = spill_directory.empty() ? std::filesystem::temp_directory_path().string() : spill_directory;
+    if (!std::filesystem::is_directory(this->spill_directory))
+        throw std::runtime_error("The spill-directory '" + this->spill_directory + "' does not exist.");
+}
+
+SortingWriter::~SortingWriter() {
+    // Only left over if the generation has been aborted.
+    if (!this->spill_path.empty()) {
+        this->spill_file.close();
+        std::error_code ignored;
+        std::filesystem::remove(this->spill_path, ignored);
+        std::filesystem::remove(merge_path(this->spill_path), ignored);
+    }
+}
+
+
+void SortingWriter::begin(const GraphSchema &schema) {
+    this->color_first.clear();
+    for (const GraphSchema::Color &c : schema.colors)
+        this->color_first.push_back(c.first);
+    this->output->begin(schema);
+}
+
+// The edges of a color are sorted anyway, so the order of the batches does not matter.
+bool SortingWriter::ordered() const {
+    return false;
+}
+
+
+void SortingWriter::writeEdges(const EdgeBatch &batch) {
+    std::unique_lock lock(this->mutex);
+    if (batch.color_id != this->color_id)
+        this->begin_color(lock, batch.color, batch.color_id);
+
+    for (size_t i = 0; i < batch.edges.size();) {
+        const size_t n = std::min(batch.edges.size() - i, this->buffer_capacity - this->buffer.size());
+        this->buffer.insert(this->buffer.end(), batch.edges.begin() + static_cast<std::ptrdiff_t>(i),
+                            batch.edges.begin() + static_cast<std::ptrdiff_t>(i + n));
+        i += n;
+        if (this->buffer.size() == this->buffer_capacity)
+            this->spill_buffer(lock);
+    }
+}
+
+void SortingWriter::writeEdge(const Edgecolor &color, const NodeID startNode, const NodeID endNode) {
+    std::unique_lock lock(this->mutex);
+    if (color != this->color || this->color_id < 0)
+        this->begin_color(lock, color, this->color_id + 1);
+
+    this->buffer.push_back(Edge{startNode, endNode});
+    if (this->buffer.size() == this->buffer_capacity)
+        this->spill_buffer(lock);
+}
+
+void SortingWriter::writeNode(const Nodetype &nodeType, const NodeID node) {
+    this->output->writeNode(nodeType, node);
+}
+
+void SortingWriter::writeNodeRange(const Nodetype &nodeType, const NodeID first, const NodeID last) {
+    this->output->writeNodeRange(nodeType, first, last);
+}
+
+void SortingWriter::finish() {
+    std::unique_lock lock(this->mutex);
+    this->finish_color(lock);
+    this->output->finish();
+}
+
+
+void SortingWriter::begin_color(std::unique_lock<std::mutex> &lock, const Edgecolor &next_color,
+                                const Index next_color_id) {
+    this->finish_color(lock);
+    this->color = next_color;
+    this->color_id = next_color_id;
+    this->buffer.reserve(this->buffer_capacity);
+}
+
+
+// Swap the full buffer with an empty one and spill it without holding the mutex, so the other threads can fill the
+//      new buffer meanwhile. A thread filling the buffer while the previous spill is still running waits for it.
+void SortingWriter::spill_buffer(std::unique_lock<std::mutex> &lock) {
+    this->wait_for_spill(lock);
+    this->spilling.swap(this->buffer);
+    this->buffer.clear();
+    this->buffer.reserve(this->buffer_capacity);
+    this->spill_running = true;
+
+    lock.unlock();
+    try {
+        this->spill(this->spilling);
+    } catch (...) {
+        lock.lock();
+        this->spill_running = false;
+        this->spill_done.notify_all();
+        throw;
+    }
+    lock.lock();
+    this->spill_running = false;
+    this->spill_done.notify_all();
+}
+
+void SortingWriter::wait_for_spill(std::unique_lock<std::mutex> &lock) {
+    this->spill_done.wait(lock, [this] { return !this->spill_running; });
+}
+
+
+// Sort the edges and append them to the spill-file as one run. The parallel sorted parts are merged while writing.
+void SortingWriter::spill(std::vector<Edge> &edges) {
+    if (this->spill_path.empty()) {
+        this->spill_path = (std::filesystem::path(this->spill_directory)
+                            / ("graphgen-" + std::to_string(::getpid()) + "-" + std::to_string(this->color_id)
+                               + ".sort")).string();
+        this->spill_file.open(this->spill_path, std::ios::binary | std::ios::trunc);
+        if (!this->spill_file.is_open())
+            throw std::runtime_error("Could not create the spill-file '" + this->spill_path + "'.");
+    }
+
+    std::vector<RunCursor> cursors;
+    for (const std::span<const Edge> part : sort_parts(edges))
+        cursors.emplace_back(part);
+    const uint64_t offset = this->spilled;
+    merge_runs(cursors, [this](const std::vector<Edge> &edges) {
+        this->spill_file.write(reinterpret_cast<const char *>(edges.data()),
+                               static_cast<std::streamsize>(edges.size() * sizeof(Edge)));
+        this->spilled += edges.size();
+    });
+    this->runs.emplace_back(offset, this->spilled - offset);
+    if (!this->spill_file)
+        throw std::runtime_error("Could not write to the spill-file '" + this->spill_path + "'. Is the disk full?");
+    edges.clear();
+}
+
+
+// Merge groups of MAX_MERGE_FANIN runs into longer runs, until at most MAX_MERGE_FANIN runs are left.
+//      Every pass reads the spill-file through one stream and writes the longer runs to a new file, which replaces it.
+void SortingWriter::reduce_runs() {
+    const size_t run_buffer = this->buffer_capacity / MAX_MERGE_FANIN;
+    while (this->runs.size() > MAX_MERGE_FANIN) {
+        const std::string merged_path = merge_path(this->spill_path);
+        std::ifstream in(this->spill_path, std::ios::binary);
+        std::ofstream out(merged_path, std::ios::binary | std::ios::trunc);
+        if (!in.is_open() || !out.is_open())
+            throw std::runtime_error("Could not open the spill-file '" + this->spill_path + "' for merging.");
+
+        std::vector<std::pair<uint64_t, uint64_t> > merged_runs;
+        uint64_t written = 0;
+        for (size_t group = 0; group < this->runs.size(); group += MAX_MERGE_FANIN) {
+            std::vector<RunCursor> cursors;
+            for (size_t r = group; r < std::min(group + MAX_MERGE_FANIN, this->runs.size()); ++r)
+                cursors.emplace_back(in, this->runs[r].first, this->runs[r].second, run_buffer);
+            const uint64_t offset = written;
+            merge_runs(cursors, [&out, &written](const std::vector<Edge> &edges) {
+                out.write(reinterpret_cast<const char *>(edges.data()),
+                          static_cast<std::streamsize>(edges.size() * sizeof(Edge)));
+                written += edges.size();
+            });
+            merged_runs.emplace_back(offset, written - offset);
+        }
+        out.close();
+        if (!out)
+            throw std::runtime_error("Could not write to the spill-file '" + merged_path + "'. Is the disk full?");
+        in.close();
+        std::filesystem::rename(merged_path, this->spill_path);
+        this->runs = std::move(merged_runs);
+    }
+}
+
+
+// Merge all runs of the current color and pass the sorted edges to the output.
+void SortingWriter::finish_color(std::unique_lock<std::mutex> &lock) {
+    if (this->color_id < 0) { return; }
+    this->wait_for_spill(lock);
+
+    std::vector<RunCursor> cursors;
+    std::ifstream spilled_runs;
+    if (this->runs.empty()) {
+        // Everything fits into memory, the sorted parts of the buffer are merged directly.
+        for (const std::span<const Edge> run : sort_parts(this->buffer))
+            cursors.emplace_back(run);
+    } else {
+        if (!this->buffer.empty())
+            this->spill(this->buffer);
+        this->spill_file.close();
+        std::vector<Edge>().swap(this->buffer);
+        std::vector<Edge>().swap(this->spilling);
+        this->reduce_runs();
+
+        // The memory budget is shared by the read-buffers of all runs.
+        spilled_runs.open(this->spill_path, std::ios::binary);
+        if (!spilled_runs.is_open())
+            throw std::runtime_error("Could not open the spill-file '" + this->spill_path + "'.");
+        const size_t run_buffer = this->buffer_capacity / this->runs.size();
+        for (const auto &[offset, length] : this->runs)
+            cursors.emplace_back(spilled_runs, offset, length, run_buffer);
+    }
+
+    Count first = this->color_id < static_cast<Index>(this->color_first.size()) ? this->color_first[this->color_id] : 0;
+    merge_runs(cursors, [this, &first](const std::vector<Edge> &merged) {
+        this->output->writeEdges(EdgeBatch{this->color, this->color_id, first, merged});
+        first += static_cast<Count>(merged.size());
+    });
+
+    cursors.clear();
+    spilled_runs.close();
+    if (!this->spill_path.empty()) {
+        std::filesystem::remove(this->spill_path);
+        this->spill_path.clear();
+    }
+    this->runs.clear();
+    this->spilled = 0;
+    this->buffer.clear();
+    this->color_id = -1;
+}
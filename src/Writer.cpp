@@ -1,39 +1,778 @@
-#include <syncstream>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
 #include "../include/GraphGenTypes.h"
+#include "../include/BinaryGraph.h"
+#include "../include/MappedFile.h"
 
 
 // Abstract-Class "GraphWriter"
 GraphWriter::~GraphWriter() = default;
+void GraphWriter::begin(const GraphSchema &schema){}
+bool GraphWriter::ordered() const { return true; }
+void GraphWriter::writeEdges(const EdgeBatch &batch){
+    for (const Edge &edge : batch.edges)
+        this->writeEdge(batch.color, edge.start, edge.end);
+}
 void GraphWriter::writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode){};
 void GraphWriter::writeNode(const Nodetype &nodeType, NodeID node){}
+void GraphWriter::writeNodeRange(const Nodetype &nodeType, const NodeID first, const NodeID last){
+    for (NodeID node = first; node < last; ++node)
+        this->writeNode(nodeType, node);
+}
+void GraphWriter::finish(){}
+
+
+
+
+// Output-file shared by the threads of a writer
+BlockOutput::BlockOutput(const std::string &path, const OutputOptions &options, std::shared_ptr<AsyncIO> io,
+                         const size_t min_block_size)
+    : file(path, options.io, std::move(io)), compression(options.compression),
+      compression_level(options.compression_level),
+      min_block_size(options.compression == Compression::NONE ? 0 : min_block_size) {}
+
+void BlockOutput::begin(const GraphSchema &schema) {
+    std::lock_guard lock(this->mutex);
+    this->color_next.clear();
+    for (const GraphSchema::Color &color : schema.colors)
+        this->color_next.push_back(color.first);
+}
+
+bool BlockOutput::knows_positions() const {
+    return !this->color_next.empty();
+}
+
+std::string_view BlockOutput::encode(const std::string_view data, std::string &storage) const {
+    if (this->compression == Compression::NONE || data.empty())
+        return data;
+    storage = compress_block(this->compression, data, this->compression_level);
+    return storage;
+}
+
+void BlockOutput::append(const std::string_view block) {
+    std::lock_guard lock(this->mutex);
+    this->write_block(block);
+}
+
+// The block is encoded by the calling thread, only the write itself waits for the preceding blocks.
+void BlockOutput::append_edges(const Index color_id, const Count first, const Count count, const std::string_view data) {
+    if (this->min_block_size > 0) {
+        this->collect_edges(color_id, first, count, data);
+        return;
+    }
+    std::string storage;
+    const std::string_view block = this->encode(data, storage);
+
+    std::unique_lock lock(this->mutex);
+    const auto id = static_cast<size_t>(color_id);
+    if (color_id >= 0 && id < this->color_next.size()) {
+        this->turn.wait(lock, [&] { return this->color_next[id] == first; });
+        this->color_next[id] += count;
+    }
+    this->write_block(block);
+    lock.unlock();
+    this->turn.notify_all();
+}
+
+// Small blocks are collected in the order of their positions first. Once the collected data reaches the minimum
+//      size, it is numbered, encoded by the calling thread and written in the order of the numbers.
+void BlockOutput::collect_edges(const Index color_id, const Count first, const Count count,
+                                const std::string_view data) {
+    std::pair<std::string, uint64_t> block;
+    {
+        std::unique_lock lock(this->mutex);
+        const auto id = static_cast<size_t>(color_id);
+        if (color_id >= 0 && id < this->color_next.size()) {
+            this->turn.wait(lock, [&] { return this->color_next[id] == first; });
+            this->color_next[id] += count;
+        }
+        block = this->collect_locked(data);
+    }
+    this->turn.notify_all();
+    if (!block.first.empty())
+        this->append_collected(block.second, block.first);
+}
+
+std::pair<std::string, uint64_t> BlockOutput::collect(const std::string_view data) {
+    std::lock_guard lock(this->mutex);
+    return this->collect_locked(data);
+}
+
+std::pair<std::string, uint64_t> BlockOutput::collect_locked(const std::string_view data) {
+    std::pair<std::string, uint64_t> block;
+    this->collected.append(data);
+    if (this->collected.size() >= this->min_block_size) {
+        block.first.swap(this->collected);
+        block.second = this->blocks_collected++;
+    }
+    return block;
+}
+
+// The block is encoded by the calling thread, only the write itself waits for the blocks with smaller numbers.
+void BlockOutput::append_collected(const uint64_t sequence, const std::string_view block) {
+    std::string storage;
+    const std::string_view encoded = this->encode(block, storage);
+    std::unique_lock lock(this->mutex);
+    this->turn.wait(lock, [&] { return this->blocks_written == sequence; });
+    this->write_block(encoded);
+    ++this->blocks_written;
+    lock.unlock();
+    this->turn.notify_all();
+}
+
+void BlockOutput::close() {
+    if (!this->collected.empty()) {
+        std::string storage;
+        const std::string_view encoded = this->encode(this->collected, storage);
+        this->write_block(encoded);
+        this->collected.clear();
+    }
+    // An empty file is no valid gzip-/zstd-file, e.g. a partition without any edges gets an empty member/frame.
+    if (!this->written && this->compression != Compression::NONE)
+        this->write_block(compress_block(this->compression, {}, this->compression_level));
+    this->file.close();
+}
+
+void BlockOutput::write_block(const std::string_view block) {
+    this->file.write(block.data(), block.size());
+    this->written = this->written || !block.empty();
+}
+
+
+// Encode the blocks of a range in chunks on all threads and append them in their order.
+//      format(first, last, buffer) writes the chunk [first, last) into the buffer.
+template<typename Format>
+static void append_range(BlockOutput &output, const NodeID first, const NodeID last, const Format &format) {
+    constexpr NodeID CHUNK_SIZE = 1 << 16;
+    const NodeID chunks = (last - first + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    #pragma omp parallel if (chunks > 1)
+    {
+        std::string buffer;
+        std::string storage;
+
+        #pragma omp for ordered schedule(dynamic, 1)
+        for (NodeID chunk = 0; chunk < chunks; ++chunk) {
+            const NodeID chunk_first = first + chunk * CHUNK_SIZE;
+            format(chunk_first, std::min(last, chunk_first + CHUNK_SIZE), buffer);
+            const std::string_view block = output.encode(buffer, storage);
+
+            #pragma omp ordered
+            output.append(block);
+        }
+    }
+}
 
 
 
 
 // Implementation for Tab-Seperated-Value files
-TSVWriter::TSVWriter(const std::string &node_file_path, const std::string &edge_file_path) {
-    this->node_file.open(node_file_path, std::ofstream::out | std::ofstream::trunc);
-    this->edge_file.open(edge_file_path, std::ofstream::out | std::ofstream::trunc);
+TSVWriter::TSVWriter(const std::string &node_file_path, const std::string &edge_file_path,
+                     const OutputOptions &options)
+    : node_output(node_file_path, options), edge_output(edge_file_path, options) {}
 
-    if (!this->node_file.is_open()) {
-        throw std::runtime_error("Could not open node-file for writing.");
+TSVWriter::~TSVWriter() = default;
+
+// Format "<start>\t<end><suffix>" for every edge into the buffer.
+static void format_edges(std::string &buffer, const std::span<const Edge> edges, const std::string_view suffix) {
+    buffer.resize(edges.size() * (2 * 20 + 1 + suffix.size()));
+    char *p = buffer.data();
+    char *const end = p + buffer.size();
+    for (const Edge &edge : edges) {
+        p = std::to_chars(p, end, edge.start).ptr;
+        *p++ = '\t';
+        p = std::to_chars(p, end, edge.end).ptr;
+        std::memcpy(p, suffix.data(), suffix.size());
+        p += suffix.size();
     }
-    if (!this->edge_file.is_open()) {
-        throw std::runtime_error("Could not open edge-file for writing.");
+    buffer.resize(static_cast<size_t>(p - buffer.data()));
+}
+
+// Format "<node><suffix>" for the nodes [first, last) into the buffer.
+static void format_nodes(std::string &buffer, const NodeID first, const NodeID last, const std::string_view suffix) {
+    buffer.resize(static_cast<size_t>(last - first) * (20 + suffix.size()));
+    char *p = buffer.data();
+    char *const end = p + buffer.size();
+    for (NodeID node = first; node < last; ++node) {
+        p = std::to_chars(p, end, node).ptr;
+        std::memcpy(p, suffix.data(), suffix.size());
+        p += suffix.size();
     }
+    buffer.resize(static_cast<size_t>(p - buffer.data()));
+}
+
+// Binary records of the edges/nodes, as bytes in the buffer.
+static void encode_edge_records(std::string &buffer, const std::span<const Edge> edges, const uint32_t color) {
+    buffer.resize(edges.size() * sizeof(EdgeRecord));
+    auto *records = reinterpret_cast<EdgeRecord *>(buffer.data());
+    for (const Edge &edge : edges)
+        *records++ = EdgeRecord{static_cast<uint64_t>(edge.start), static_cast<uint64_t>(edge.end), color, 0};
 }
 
-TSVWriter::~TSVWriter() {
-    this->node_file.close();
-    this->edge_file.close();
+static void encode_node_records(std::string &buffer, const NodeID first, const NodeID last, const uint32_t type) {
+    buffer.resize(static_cast<size_t>(last - first) * sizeof(NodeRecord));
+    auto *records = reinterpret_cast<NodeRecord *>(buffer.data());
+    for (NodeID node = first; node < last; ++node)
+        *records++ = NodeRecord{static_cast<uint64_t>(node), type, 0};
+}
+
+void TSVWriter::begin(const GraphSchema &schema) {
+    for (const GraphSchema::Color &color : schema.colors)
+        this->color_suffix.push_back("\t" + color.name + "\n");
+    this->edge_output.begin(schema);
+}
+
+// Without a schema, the positions of the batches are unknown and the generator has to pass them in order.
+bool TSVWriter::ordered() const {
+    return !this->edge_output.knows_positions();
+}
+
+void TSVWriter::writeEdges(const EdgeBatch &batch) {
+    thread_local std::string buffer;
+    const auto id = static_cast<size_t>(batch.color_id);
+    const bool known = batch.color_id >= 0 && id < this->color_suffix.size();
+    format_edges(buffer, batch.edges, known ? this->color_suffix[id] : "\t" + batch.color + "\n");
+    this->edge_output.append_edges(batch.color_id, batch.first, static_cast<Count>(batch.edges.size()), buffer);
 }
 
 void TSVWriter::writeEdge(const Edgecolor &color, const NodeID startNode, const NodeID endNode) {
-    std::osyncstream(this->edge_file) << startNode << "\t" << endNode << "\t" << color << std::endl;
+    const Edge edge{startNode, endNode};
+    std::string buffer;
+    std::string storage;
+    format_edges(buffer, {&edge, 1}, "\t" + color + "\n");
+    this->edge_output.append(this->edge_output.encode(buffer, storage));
 }
 
 void TSVWriter::writeNode(const Nodetype &nodeType, const NodeID node) {
-    std::osyncstream(this->edge_file) << node << "\t" << nodeType << std::endl;
+    this->writeNodeRange(nodeType, node, node + 1);
+}
+
+void TSVWriter::writeNodeRange(const Nodetype &nodeType, const NodeID first, const NodeID last) {
+    const std::string suffix = "\t" + nodeType + "\n";
+    append_range(this->node_output, first, last, [&suffix](const NodeID chunk_first, const NodeID chunk_last,
+                                                             std::string &buffer) {
+        format_nodes(buffer, chunk_first, chunk_last, suffix);
+    });
+}
+
+void TSVWriter::finish() {
+    this->node_output.close();
+    this->edge_output.close();
+}
+
+
+
+
+// Implementation for the binary graph format
+BinaryWriter::BinaryWriter(const std::string &node_file_path, const std::string &edge_file_path,
+                           const OutputOptions &options)
+    : node_path(node_file_path), edge_path(edge_file_path), options(options) {}
+
+BinaryWriter::~BinaryWriter() = default;
+
+// Header of a file up to the length of its record-array, in the format of BinaryOut.
+static std::string binary_header(const uint64_t magic, const std::vector<std::string> &names, const uint64_t records) {
+    std::string header;
+    const auto put = [&header](const uint64_t value) { header.append(reinterpret_cast<const char *>(&value), 8); };
+    put(magic);
+    put(BINARY_GRAPH_VERSION);
+    put(names.size());
+    for (const std::string &name : names) {
+        put(name.size());
+        header += name;
+        header.resize((header.size() + 7) / 8 * 8, '\0');
+    }
+    put(records);
+    return header;
+}
+
+void BinaryWriter::begin(const GraphSchema &schema) {
+    std::vector<std::string> type_names;
+    this->first_id = schema.types.empty() ? 0 : schema.types.front().first;
+    this->nbr_nodes = 0;
+    for (const GraphSchema::Type &type : schema.types) {
+        this->type_index.emplace(type.name, static_cast<uint32_t>(type_names.size()));
+        type_names.push_back(type.name);
+        this->nbr_nodes += type.count;
+    }
+
+    Count nbr_edges = 0;
+    for (const GraphSchema::Color &color : schema.colors) {
+        this->color_names.push_back(color.name);
+        this->color_first.push_back(color.first);
+        this->color_base.push_back(nbr_edges);
+        this->color_capacity.push_back(color.count);
+        nbr_edges += color.count;
+    }
+    this->color_written = std::make_unique<std::atomic<Count>[]>(schema.colors.size());
+
+    const std::string node_header = binary_header(BINARY_NODES_MAGIC, type_names, this->nbr_nodes);
+    const std::string edge_header = binary_header(BINARY_EDGES_MAGIC, this->color_names, nbr_edges);
+
+    if (this->options.compression != Compression::NONE) {
+        this->node_output = std::make_unique<BlockOutput>(this->node_path, this->options);
+        this->edge_output = std::make_unique<BlockOutput>(this->edge_path, this->options);
+        this->edge_output->begin(schema);
+        this->node_output->append(store_block(this->options.compression, node_header));
+        this->edge_output->append(store_block(this->options.compression, edge_header));
+        return;
+    }
+
+    this->node_offset = node_header.size();
+    this->edge_offset = edge_header.size();
+    this->node_map = std::make_unique<WritableMappedFile>(this->node_path,
+                                                          this->node_offset + this->nbr_nodes * sizeof(NodeRecord));
+    this->edge_map = std::make_unique<WritableMappedFile>(this->edge_path,
+                                                          this->edge_offset + nbr_edges * sizeof(EdgeRecord));
+    std::memcpy(this->node_map->data(), node_header.data(), node_header.size());
+    std::memcpy(this->edge_map->data(), edge_header.data(), edge_header.size());
+}
+
+bool BinaryWriter::ordered() const {
+    return false;
+}
+
+Count BinaryWriter::edge_capacity() const {
+    return this->color_base.empty() ? 0 : this->color_base.back() + this->color_capacity.back();
+}
+
+void BinaryWriter::writeEdges(const EdgeBatch &batch) {
+    if (!this->edge_map && !this->edge_output)
+        throw std::logic_error("The binary writer needs the schema of the graph before any edges.");
+    const auto id = static_cast<size_t>(batch.color_id);
+    const Count pos = batch.first - this->color_first.at(id);
+    if (pos < 0 || pos + static_cast<Count>(batch.edges.size()) > this->color_capacity[id])
+        throw std::out_of_range("Edges " + std::to_string(batch.first) + "+" + std::to_string(batch.edges.size())
+                                + " are outside of the color '" + batch.color + "' of the schema.");
+
+    this->color_written[id] += static_cast<Count>(batch.edges.size());
+    if (this->edge_output) {
+        thread_local std::string buffer;
+        encode_edge_records(buffer, batch.edges, static_cast<uint32_t>(id));
+        this->edge_output->append_edges(batch.color_id, batch.first, static_cast<Count>(batch.edges.size()), buffer);
+        return;
+    }
+
+    auto *records = reinterpret_cast<EdgeRecord *>(this->edge_map->data() + this->edge_offset) + this->color_base[id] + pos;
+    for (const Edge &edge : batch.edges)
+        *records++ = EdgeRecord{static_cast<uint64_t>(edge.start), static_cast<uint64_t>(edge.end),
+                                static_cast<uint32_t>(id), 0};
+}
+
+void BinaryWriter::writeEdge(const Edgecolor &color, NodeID startNode, NodeID endNode) {
+    throw std::logic_error("The binary writer places edges by their position, it only accepts batches.");
+}
+
+void BinaryWriter::writeNode(const Nodetype &nodeType, const NodeID node) {
+    this->writeNodeRange(nodeType, node, node + 1);
+}
+
+void BinaryWriter::writeNodeRange(const Nodetype &nodeType, const NodeID first, const NodeID last) {
+    if (!this->node_map && !this->node_output)
+        throw std::logic_error("The binary writer needs the schema of the graph before any nodes.");
+    if (first < this->first_id || last > this->first_id + this->nbr_nodes)
+        throw std::out_of_range("Nodes " + std::to_string(first) + " to " + std::to_string(last - 1)
+                                + " are outside of the schema.");
+
+    const uint32_t type = this->type_index.at(nodeType);
+    if (this->node_output) {
+        append_range(*this->node_output, first, last, [type](const NodeID chunk_first, const NodeID chunk_last,
+                                                              std::string &buffer) {
+            encode_node_records(buffer, chunk_first, chunk_last, type);
+        });
+        return;
+    }
+
+    auto *records = reinterpret_cast<NodeRecord *>(this->node_map->data() + this->node_offset);
+    #pragma omp parallel for schedule(static) if (last - first > 1)
+    for (NodeID node = first; node < last; ++node)
+        records[node - this->first_id] = NodeRecord{static_cast<uint64_t>(node), type, 0};
+}
+
+void BinaryWriter::finish() {
+    Count written = 0;
+    for (size_t id = 0; id < this->color_base.size(); ++id)
+        written += this->color_written[id];
+
+    if (this->edge_output) {
+        this->node_output->close();
+        this->edge_output->close();
+        // The stored header-block has the same size with the actual number of edges, it is replaced in place.
+        if (written != this->edge_capacity()) {
+            const std::string header = store_block(this->options.compression,
+                                                   binary_header(BINARY_EDGES_MAGIC, this->color_names, written));
+            std::fstream file(this->edge_path, std::ios::in | std::ios::out | std::ios::binary);
+            file.write(header.data(), static_cast<std::streamsize>(header.size()));
+            if (!file)
+                throw std::runtime_error("Could not update the header of '" + this->edge_path + "'.");
+        }
+        return;
+    }
+    if (!this->edge_map) { return; }
+
+    // Move the edges of every color to the front of its region, if edges have been left out, and cut off the rest.
+    auto *records = reinterpret_cast<EdgeRecord *>(this->edge_map->data() + this->edge_offset);
+    written = 0;
+    for (size_t id = 0; id < this->color_base.size(); ++id) {
+        const Count count = this->color_written[id];
+        if (written != this->color_base[id])
+            std::memmove(records + written, records + this->color_base[id], count * sizeof(EdgeRecord));
+        written += count;
+    }
+    if (written != this->edge_capacity()) {
+        const auto length = static_cast<uint64_t>(written);
+        std::memcpy(this->edge_map->data() + this->edge_offset - sizeof(length), &length, sizeof(length));
+        this->edge_map->resize(this->edge_offset + written * sizeof(EdgeRecord));
+    }
+
+    this->edge_map->close();
+    this->node_map->close();
+}
+
+
+
+
+// Implementation for partitioned output
+
+// With compression, the parts of the batches are collected per file up to this size, before they are compressed.
+constexpr size_t PARTITION_MIN_BLOCK_SIZE = size_t{256} << 10;
+
+PartitionedWriter::PartitionedWriter(const OutputFormat format, const std::string &node_file_path,
+                                     const std::string &edge_file_path, const bool by_color, const Count id_partitions,
+                                     const OutputOptions &options)
+    : format(format), node_path(node_file_path), edge_path(edge_file_path), by_color(by_color),
+      id_partitions(id_partitions), options(options) {
+    if (id_partitions < 1)
+        throw std::invalid_argument("The output needs at least one partition.");
+}
+
+PartitionedWriter::~PartitionedWriter() = default;
+
+std::string PartitionedWriter::partition_path(const std::string &path, const std::string &color, const Count partition,
+                                              const Count partitions) {
+    const std::filesystem::path file(path);
+    const std::string name = file.filename().string();
+    const size_t dot = name.find('.', 1);
+    std::string stem = name.substr(0, dot);
+    const std::string extension = dot == std::string::npos ? "" : name.substr(dot);
+
+    if (!color.empty()) {
+        stem += '.';
+        for (const char c : color)
+            stem += std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ? c : '_';
+    }
+    if (partitions > 1) {
+        std::ostringstream suffix;
+        suffix << ".part-" << std::setw(static_cast<int>(std::to_string(partitions - 1).size())) << std::setfill('0')
+               << partition;
+        stem += suffix.str();
+    }
+    return (file.parent_path() / (stem + extension)).string();
+}
+
+void PartitionedWriter::begin(const GraphSchema &graph_schema) {
+    this->schema = graph_schema;
+    for (Index id = 0; id < static_cast<Index>(this->schema.colors.size()); ++id) {
+        this->color_suffix.push_back("\t" + this->schema.colors[id].name + "\n");
+        this->color_index.emplace(this->schema.colors[id].name, id);
+    }
+    for (const GraphSchema::Type &type : this->schema.types)
+        this->type_index.emplace(type.name, static_cast<uint32_t>(this->type_index.size()));
+
+    this->partition_options = this->options;
+    this->partition_options.io.buffer_size = std::max<size_t>(this->options.io.buffer_size / this->id_partitions,
+                                                              size_t{256} << 10);
+
+    // All files share one I/O-thread. The node-files are opened when their first nodes are written.
+    this->io = std::make_shared<AsyncIO>(this->partition_options.io);
+    for (Count p = 0; p < this->id_partitions; ++p) {
+        auto partition = std::make_unique<Partition>();
+        partition->path = this->id_partitions > 1 ? partition_path(this->node_path, "", p, this->id_partitions)
+                                                  : this->node_path;
+        partition->first_id = this->partition_bound(p);
+        partition->last_id = this->partition_bound(p + 1) - 1;
+        this->node_partitions.push_back(std::move(partition));
+    }
+
+    // Colors are named by their label in the file-names. Colors with the same label get their color_id appended.
+    std::unordered_set<std::string> used_paths;
+    const size_t slots = this->by_color ? this->schema.colors.size() : 1;
+    for (size_t slot = 0; slot < slots; ++slot) {
+        const Edgecolor color = this->by_color ? this->schema.colors[slot].name : "";
+        std::string label = color;
+        if (this->by_color && !used_paths.insert(partition_path(this->edge_path, label, 0, 1)).second)
+            label += "-" + std::to_string(slot);
+
+        for (Count p = 0; p < this->id_partitions; ++p) {
+            auto partition = std::make_unique<Partition>();
+            partition->path = partition_path(this->edge_path, label, p, this->id_partitions);
+            partition->color = color;
+            partition->first_id = this->partition_bound(p);
+            partition->last_id = this->partition_bound(p + 1) - 1;
+            if (!this->by_color)
+                this->open(*partition, false);
+            this->edge_partitions.push_back(std::move(partition));
+        }
+    }
+}
+
+// The schema is needed to find the files of the batches, the generator always passes it.
+bool PartitionedWriter::ordered() const {
+    return false;
+}
+
+NodeID PartitionedWriter::partition_bound(const Count partition) const {
+    __extension__ typedef unsigned __int128 uint128;
+    return this->schema.first_node
+           + static_cast<NodeID>(static_cast<uint128>(this->schema.nbr_nodes) * static_cast<uint128>(partition)
+                                 / static_cast<uint128>(this->id_partitions));
+}
+
+// The partition p with partition_bound(p) <= node < partition_bound(p + 1), IDs outside of the graph are clamped.
+Count PartitionedWriter::partition_of(const NodeID node) const {
+    __extension__ typedef unsigned __int128 uint128;
+    if (this->id_partitions == 1 || this->schema.nbr_nodes == 0) { return 0; }
+    const NodeID offset = std::clamp<NodeID>(node - this->schema.first_node, 0, this->schema.nbr_nodes - 1);
+    return static_cast<Count>((static_cast<uint128>(this->id_partitions) * static_cast<uint128>(offset + 1) - 1)
+                              / static_cast<uint128>(this->schema.nbr_nodes));
+}
+
+PartitionedWriter::Partition &PartitionedWriter::edge_partition(const Index color_id, const Count partition) {
+    const size_t slot = this->by_color ? static_cast<size_t>(color_id) : 0;
+    return *this->edge_partitions.at(slot * this->id_partitions + partition);
+}
+
+// Colors are generated one after the other, the files of the previous color are complete when the next one starts.
+//      The color is published after its files are opened, so threads seeing it need no lock.
+void PartitionedWriter::open_color_files(const Index color_id) {
+    std::lock_guard lock(this->open_mutex);
+    const Index previous = this->open_color.load(std::memory_order_relaxed);
+    if (color_id == previous) { return; }
+    if (previous >= 0) {
+        {
+            std::unique_lock pending_lock(this->pending_mutex);
+            this->append_pending(pending_lock, previous, true);
+        }
+        for (Count p = 0; p < this->id_partitions; ++p)
+            this->close(this->edge_partition(previous, p), false);
+    }
+    for (Count p = 0; p < this->id_partitions; ++p)
+        this->open(this->edge_partition(color_id, p), false);
+    this->open_color.store(color_id, std::memory_order_release);
+}
+
+void PartitionedWriter::open(Partition &partition, const bool nodes) {
+    partition.output = std::make_unique<BlockOutput>(partition.path, this->partition_options, this->io,
+                                                     PARTITION_MIN_BLOCK_SIZE);
+    partition.output->begin(this->schema);
+    partition.opened = true;
+    if (this->format != OutputFormat::BINARY) { return; }
+
+    // Binary files start with a stored header, its record count is replaced when the file is closed.
+    std::vector<std::string> names;
+    if (nodes)
+        for (const GraphSchema::Type &type : this->schema.types)
+            names.push_back(type.name);
+    else if (!partition.color.empty())
+        names.push_back(partition.color);
+    else
+        for (const GraphSchema::Color &color : this->schema.colors)
+            names.push_back(color.name);
+    partition.output->append(store_block(this->options.compression,
+                                         binary_header(nodes ? BINARY_NODES_MAGIC : BINARY_EDGES_MAGIC, names, 0)));
+}
+
+void PartitionedWriter::close(Partition &partition, const bool nodes) {
+    if (!partition.output) { return; }
+    partition.output->close();
+    partition.output.reset();
+    if (this->format != OutputFormat::BINARY) { return; }
+
+    // Recreate the header with the final count. The stored block has the same size, it is replaced in place.
+    std::string header;
+    {
+        std::vector<std::string> names;
+        if (nodes)
+            for (const GraphSchema::Type &type : this->schema.types)
+                names.push_back(type.name);
+        else if (!partition.color.empty())
+            names.push_back(partition.color);
+        else
+            for (const GraphSchema::Color &color : this->schema.colors)
+                names.push_back(color.name);
+        header = store_block(this->options.compression, binary_header(nodes ? BINARY_NODES_MAGIC : BINARY_EDGES_MAGIC,
+                                                                      names, partition.records));
+    }
+    std::fstream file(partition.path, std::ios::in | std::ios::out | std::ios::binary);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    if (!file)
+        throw std::runtime_error("Could not update the header of '" + partition.path + "'.");
+}
+
+// Every batch is split by the partitions of the start-nodes and formatted by the calling thread. The batch is left
+//      behind for its predecessors, unless it is the next one of the color: Then the thread appends it and all
+//      following batches left behind meanwhile, so every file gets its parts in the order of the positions.
+void PartitionedWriter::writeEdges(const EdgeBatch &batch) {
+    if (this->schema.colors.empty())
+        throw std::logic_error("The partitioned writer needs the schema of the graph before any edges.");
+    if (this->by_color && this->open_color.load(std::memory_order_acquire) != batch.color_id)
+        this->open_color_files(batch.color_id);
+
+    thread_local std::vector<std::vector<Edge> > parts;
+    thread_local std::string buffer;
+    parts.resize(static_cast<size_t>(this->id_partitions));
+    for (std::vector<Edge> &part : parts)
+        part.clear();
+    for (const Edge &edge : batch.edges)
+        parts[this->partition_of(edge.start)].push_back(edge);
+
+    PendingBatch formatted;
+    formatted.count = static_cast<Count>(batch.edges.size());
+    const auto color = static_cast<uint32_t>(this->by_color ? 0 : batch.color_id);
+    for (Count p = 0; p < this->id_partitions; ++p) {
+        const std::vector<Edge> &part = parts[p];
+        if (part.empty()) { continue; }
+        if (this->format == OutputFormat::BINARY)
+            encode_edge_records(buffer, part, color);
+        else
+            format_edges(buffer, part, this->color_suffix.at(batch.color_id));
+        formatted.parts.emplace_back(p, formatted.data.size(), buffer.size());
+        formatted.data += buffer;
+        this->edge_partition(batch.color_id, p).records += static_cast<Count>(part.size());
+    }
+
+    std::unique_lock lock(this->pending_mutex);
+    if (batch.color_id != this->pending_color) {
+        this->append_pending(lock, this->pending_color, true);
+        this->pending_color = batch.color_id;
+        this->pending_next = this->schema.colors.at(batch.color_id).first;
+    }
+    this->pending.emplace(batch.first, std::move(formatted));
+    this->append_pending(lock, batch.color_id, false);
+}
+
+// Append the batches following the last appended one, or all batches left behind. Only one thread appends at once,
+//      it takes the batches under the lock and appends them without it. Full blocks of compressed files are collected
+//      and compressed after the batches, so the compression runs on the threads concurrently.
+void PartitionedWriter::append_pending(std::unique_lock<std::mutex> &lock, const Index color_id, const bool all) {
+    if (this->appending) { return; }
+    this->appending = true;
+    std::vector<std::tuple<BlockOutput *, uint64_t, std::string> > blocks;
+    while (!this->pending.empty() && (all || this->pending.begin()->first == this->pending_next)) {
+        PendingBatch batch = std::move(this->pending.begin()->second);
+        this->pending_next = this->pending.begin()->first + batch.count;
+        this->pending.erase(this->pending.begin());
+
+        lock.unlock();
+        for (const auto &[p, offset, length] : batch.parts) {
+            BlockOutput &output = *this->edge_partition(color_id, p).output;
+            const std::string_view data(batch.data.data() + offset, length);
+            if (this->options.compression == Compression::NONE) {
+                output.append(data);
+            } else if (auto [block, sequence] = output.collect(data); !block.empty()) {
+                blocks.emplace_back(&output, sequence, std::move(block));
+            }
+        }
+        lock.lock();
+    }
+    this->appending = false;
+
+    lock.unlock();
+    for (const auto &[output, sequence, block] : blocks)
+        output->append_collected(sequence, block);
+    lock.lock();
+}
+
+void PartitionedWriter::writeEdge(const Edgecolor &color, const NodeID startNode, const NodeID endNode) {
+    const Index color_id = this->color_index.at(color);
+    if (this->by_color)
+        this->open_color_files(color_id);
+
+    const Edge edge{startNode, endNode};
+    std::string buffer;
+    std::string storage;
+    if (this->format == OutputFormat::BINARY)
+        encode_edge_records(buffer, {&edge, 1}, static_cast<uint32_t>(this->by_color ? 0 : color_id));
+    else
+        format_edges(buffer, {&edge, 1}, this->color_suffix[color_id]);
+    Partition &partition = this->edge_partition(color_id, this->partition_of(startNode));
+    ++partition.records;
+    partition.output->append(partition.output->encode(buffer, storage));
+}
+
+void PartitionedWriter::writeNode(const Nodetype &nodeType, const NodeID node) {
+    this->writeNodeRange(nodeType, node, node + 1);
+}
+
+void PartitionedWriter::writeNodeRange(const Nodetype &nodeType, const NodeID first, const NodeID last) {
+    if (first >= last) { return; }
+    const std::string suffix = "\t" + nodeType + "\n";
+    const uint32_t type = this->type_index.at(nodeType);
+
+    for (Count p = this->partition_of(first); p <= this->partition_of(last - 1); ++p) {
+        Partition &partition = *this->node_partitions.at(p);
+        const NodeID range_first = std::max(first, partition.first_id);
+        const NodeID range_last = std::min(last, partition.last_id + 1);
+        {
+            std::lock_guard lock(this->open_mutex);
+            if (!partition.opened)
+                this->open(partition, true);
+        }
+        append_range(*partition.output, range_first, range_last, [&](const NodeID chunk_first, const NodeID chunk_last,
+                                                                      std::string &buffer) {
+            if (this->format == OutputFormat::BINARY)
+                encode_node_records(buffer, chunk_first, chunk_last, type);
+            else
+                format_nodes(buffer, chunk_first, chunk_last, suffix);
+        });
+
+        // Every ID is written once, the range completing a partition closes its file.
+        const Count count = range_last - range_first;
+        if (partition.records.fetch_add(count) + count == partition.last_id - partition.first_id + 1) {
+            std::lock_guard lock(this->open_mutex);
+            this->close(partition, true);
+        }
+    }
+}
+
+void PartitionedWriter::finish() {
+    {
+        std::unique_lock lock(this->pending_mutex);
+        this->append_pending(lock, this->pending_color, true);
+    }
+    for (const std::unique_ptr<Partition> &partition : this->edge_partitions)
+        this->close(*partition, false);
+    // Every range of IDs gets its node-file, also if it is empty.
+    for (const std::unique_ptr<Partition> &partition : this->node_partitions) {
+        if (!partition->opened)
+            this->open(*partition, true);
+        this->close(*partition, true);
+    }
+
+    // The manifest lists all written files by their names, relative to the manifest.
+    const std::filesystem::path edges(this->edge_path);
+    const std::string name = edges.filename().string();
+    const std::string manifest_path = (edges.parent_path() / (name.substr(0, name.find('.', 1)) + ".manifest.tsv")).string();
+    std::ofstream manifest(manifest_path, std::ofstream::out | std::ofstream::trunc);
+    manifest << "# kind\tfile\tcolor\tfirst_id\tlast_id\trecords\n";
+    const auto list = [&manifest](const char *kind, const Partition &partition) {
+        if (!partition.opened) { return; }
+        manifest << kind << "\t" << std::filesystem::path(partition.path).filename().string() << "\t"
+                 << (partition.color.empty() ? "*" : partition.color) << "\t" << partition.first_id << "\t"
+                 << partition.last_id << "\t" << partition.records << "\n";
+    };
+    for (const std::unique_ptr<Partition> &partition : this->node_partitions)
+        list("nodes", *partition);
+    for (const std::unique_ptr<Partition> &partition : this->edge_partitions)
+        list("edges", *partition);
+    manifest.close();
+    if (!manifest)
+        throw std::runtime_error("Could not write the manifest '" + manifest_path + "'.");
 }
 
 
@@ -52,6 +791,17 @@ void BenchmarkWriter::writeNode([[maybe_unused]] const Nodetype &nodeType,
     this->write_size_nodes += sizeof(nodeType) + sizeof(std::to_string(node)) + this->node_padding;
 }
 
+void BenchmarkWriter::writeNodeRange([[maybe_unused]] const Nodetype &nodeType,
+                                     const NodeID first, const NodeID last) {
+    // NOLINTNEXTLINE(bugprone-sizeof-container)
+    this->write_size_nodes += (last - first) * (sizeof(nodeType) + sizeof(std::string) + this->node_padding);
+}
+
+void BenchmarkWriter::writeEdges(const EdgeBatch &batch) {
+    // NOLINTNEXTLINE(bugprone-sizeof-container)
+    this->write_size_edges += batch.edges.size() * (sizeof(batch.color) + 2 * sizeof(std::string) + this->edge_padding);
+}
+
 void BenchmarkWriter::writeEdge([[maybe_unused]] const Edgecolor &color,
                                 [[maybe_unused]] NodeID startNode,
                                 [[maybe_unused]] NodeID endNode) {
@@ -31,7 +31,8 @@ int main() {
     };
 
     auto start = std::chrono::steady_clock::now();
-    NodeType test = NodeType("Test_Blau", 0, 10000, cl_in, cl_out);
+    NodeType test = NodeType("Test_Blau", 0, 10000, cl_in, cl_out, 42);
+    CounterRng rng(42);
     auto finish = std::chrono::steady_clock::now();
     double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
     std::cout << "Konstruktion: " << elapsed_seconds << "s." << std::endl;
@@ -44,8 +45,8 @@ int main() {
     start = std::chrono::steady_clock::now();
     for (int i = 0; i < N; i++)
     {
-        NodeID id_start = test.get_start_node("Red");
-        NodeID id_target = test.get_target_node("Red");
+        NodeID id_start = test.get_start_node("Red", rng);
+        NodeID id_target = test.get_target_node("Red", rng);
 
         // results_start[id_start]++;
         // results_target[id_target]++;
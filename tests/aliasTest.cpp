@@ -11,11 +11,12 @@ int main(){
     
 
     AliasTable<int> al(probs);
+    CounterRng rng(42);
     std::vector<int> counts;
         counts.resize(4, 0);
 
     for (int i = 0; i < 10000000; i++)
-        ++counts[al.getElement()];
+        ++counts[al.getElement(rng)];
 
     for (int i = 0; i < counts.size(); i++)
         std::cout << "counts[" << i << "] = " << (counts[i] / 10000000.0f) << std::endl;
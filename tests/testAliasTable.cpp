@@ -0,0 +1,65 @@
+#include <cmath>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "catch2/benchmark/catch_benchmark.hpp"
+
+#include "../src/AliasTable.cpp"
+
+// Skewed table with many slots, so every kernel runs its vectorized loop and its scalar remainder.
+static AliasTable<int> skewed_table(const int n) {
+    std::vector<std::pair<probability, int> > elements;
+    double sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += 1.0 / (i + 1);
+    for (int i = 0; i < n; ++i)
+        elements.emplace_back(1.0 / (i + 1) / sum, i);
+    return AliasTable<int>(elements);
+}
+
+TEST_CASE("Drawn elements follow the given distribution", "[alias]") {
+    AliasTable<int> table(std::vector<std::pair<probability, int> >{{0.5, 0}, {0.1, 1}, {0.1, 2}, {0.3, 3}});
+    CounterRng rng(42);
+
+    std::vector<int> counts(4, 0);
+    const int draws = 1000000;
+    for (int i = 0; i < draws; ++i)
+        ++counts[table.getElement(rng)];
+
+    REQUIRE(std::abs(counts[0] / static_cast<double>(draws) - 0.5) < 0.005);
+    REQUIRE(std::abs(counts[1] / static_cast<double>(draws) - 0.1) < 0.005);
+    REQUIRE(std::abs(counts[2] / static_cast<double>(draws) - 0.1) < 0.005);
+    REQUIRE(std::abs(counts[3] / static_cast<double>(draws) - 0.3) < 0.005);
+}
+
+TEST_CASE("Batch-Sampling is identical to scalar draws for every kernel", "[alias]") {
+    const AliasTable<int> table = skewed_table(1000);
+
+    for (const AliasKernel kernel : {AliasKernel::SCALAR, AliasKernel::AVX2, AliasKernel::AVX512}) {
+        if (!alias_kernel_supported(kernel)) { continue; }
+
+        CounterRng scalar_rng(7);
+        CounterRng batch_rng(7);
+        std::vector<AliasIndex> batch(4099);
+        alias_fill(kernel, table.get_thresholds(), table.get_aliases(), batch_rng, batch);
+
+        for (const AliasIndex idx : batch)
+            REQUIRE(table.get_elements()[idx] == table.getElement(scalar_rng));
+        REQUIRE(batch_rng() == scalar_rng());
+    }
+}
+
+TEST_CASE("Benchmarks on Alias-Sampling", "[alias]") {
+    const AliasTable<int> table = skewed_table(100000);
+    CounterRng rng(1);
+    std::vector<AliasIndex> batch(4096);
+
+    BENCHMARK("Scalar draws"){
+        for (AliasIndex &idx : batch)
+            idx = static_cast<AliasIndex>(table.getElement(rng));
+        return batch.back();
+    };
+    BENCHMARK("Batch draws"){
+        table.fill(rng, batch);
+        return batch.back();
+    };
+}
@@ -0,0 +1,77 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/AsyncFile.cpp"
+
+static std::string read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+// Write pieces of varying size, so they are split across many buffers of the pool.
+static void check_async_output(const AsyncFileOptions &options) {
+    const std::string path = (std::filesystem::temp_directory_path() / "graphgen-test-async.out").string();
+    std::string expected;
+    {
+        AsyncFile file(path, options);
+        for (int i = 0; i < 20000; ++i) {
+            const std::string piece = std::to_string(i) + std::string(static_cast<size_t>(i % 97), 'x') + "\n";
+            file.write(piece.data(), piece.size());
+            expected += piece;
+        }
+        file.close();
+    }
+    REQUIRE(read_file(path) == expected);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Asynchronous output keeps the order of the writes", "[io]") {
+    check_async_output(AsyncFileOptions{4096, 2, false});
+    check_async_output(AsyncFileOptions{100000, 5, false});
+}
+
+TEST_CASE("Direct output is cut to its size", "[io]") {
+    // Falls back to buffered output on file-systems without O_DIRECT (e.g. tmpfs).
+    check_async_output(AsyncFileOptions{8192, 3, true});
+}
+
+TEST_CASE("Remaining data is written when the file is destroyed", "[io]") {
+    const std::string path = (std::filesystem::temp_directory_path() / "graphgen-test-async-dtor.out").string();
+    {
+        AsyncFile file(path, AsyncFileOptions{});
+        file.write("abc", 3);
+    }
+    REQUIRE(read_file(path) == "abc");
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Files share the I/O-thread and buffers of an AsyncIO", "[io]") {
+    // More files than buffers in flight, written interleaved and closed one after another.
+    const auto io = std::make_shared<AsyncIO>(AsyncFileOptions{4096, 3, false});
+    std::vector<std::string> paths;
+    std::vector<std::string> expected(10);
+    std::vector<std::unique_ptr<AsyncFile> > files;
+    for (size_t f = 0; f < expected.size(); ++f) {
+        paths.push_back((std::filesystem::temp_directory_path() / ("graphgen-test-shared-" + std::to_string(f))).string());
+        files.push_back(std::make_unique<AsyncFile>(paths.back(), AsyncFileOptions{}, io));
+    }
+    for (int i = 0; i < 5000; ++i) {
+        const size_t f = static_cast<size_t>(i * 7) % files.size();
+        const std::string piece = std::to_string(i) + std::string(static_cast<size_t>(i % 53), 'y') + "\n";
+        files[f]->write(piece.data(), piece.size());
+        expected[f] += piece;
+    }
+    for (const std::unique_ptr<AsyncFile> &file : files)
+        file->close();
+    files.clear();
+
+    for (size_t f = 0; f < paths.size(); ++f) {
+        REQUIRE(read_file(paths[f]) == expected[f]);
+        std::filesystem::remove(paths[f]);
+    }
+}
@@ -0,0 +1,52 @@
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/Compression.cpp"
+
+static std::string decompress(const Compression compression, const std::string &input) {
+    const std::unique_ptr<Decompressor> decompressor = Decompressor::create(compression, input);
+    std::string out;
+    char buffer[1000];
+    for (size_t n; (n = decompressor->read(buffer, sizeof(buffer))) > 0;)
+        out.append(buffer, n);
+    return out;
+}
+
+// Concatenated blocks of every kind form one stream, which is read back as a whole.
+static void check_blocks(const Compression compression) {
+    std::vector<std::string> parts;
+    for (int i = 0; i < 50; ++i)
+        parts.push_back(std::string(static_cast<size_t>(i * 997), static_cast<char>('a' + i % 26)) + std::to_string(i));
+    parts.push_back(std::string(300000, 'z'));
+    parts.push_back("");
+
+    std::string stream;
+    std::string expected;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        stream += i % 3 == 0 ? store_block(compression, parts[i]) : compress_block(compression, parts[i], i % 2 ? 1 : 0);
+        expected += parts[i];
+    }
+    REQUIRE(detect_compression(stream) == compression);
+    REQUIRE(decompress(compression, stream) == expected);
+
+    // Stored blocks only depend on the size of the data.
+    REQUIRE(store_block(compression, std::string(5000, 'a')).size() == store_block(compression, std::string(5000, 'b')).size());
+}
+
+#ifdef GRAPHGEN_HAVE_ZLIB
+TEST_CASE("gzip-blocks form a multi-member stream", "[compression]") {
+    check_blocks(Compression::GZIP);
+}
+#endif
+
+#ifdef GRAPHGEN_HAVE_ZSTD
+TEST_CASE("zstd-blocks form a multi-frame stream", "[compression]") {
+    check_blocks(Compression::ZSTD);
+}
+#endif
+
+TEST_CASE("Uncompressed blocks are passed through", "[compression]") {
+    REQUIRE(compress_block(Compression::NONE, "abc") == "abc");
+    REQUIRE(store_block(Compression::NONE, "abc") == "abc");
+}
@@ -0,0 +1,89 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../include/ConfigParser.h"
+#include "../src/EdgeDistribution.cpp"
+#include "../src/GraphModel.cpp"
+#include "../src/InputModel.cpp"
+#include "../src/NodeType.cpp"
+
+// A small random input of two node-types and two colors.
+static InputModel tiny_input() {
+    InputModel model;
+    CounterRng rng(11);
+    for (int i = 0; i < 400; ++i)
+        model.readNode(std::to_string(i), i % 3 == 0 ? "a" : "b");
+    for (int i = 0; i < 5000; ++i)
+        model.readEdge(std::to_string(rng.below(400)), std::to_string(rng.below(400)), i % 4 == 0 ? "x" : "y");
+    return model;
+}
+
+static std::string read_file(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+// Generate the shards of the model into TSV-files and return the concatenated (nodes, edges).
+static std::pair<std::string, std::string> generate_shards(GraphModel &graph, const Count shards) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string nodes, edges;
+    for (Count shard = 0; shard < shards; ++shard) {
+        const std::string node_file = (dir / ("graphgen-test-shard-" + std::to_string(shard) + "-nodes.tsv")).string();
+        const std::string edge_file = (dir / ("graphgen-test-shard-" + std::to_string(shard) + "-edges.tsv")).string();
+        {
+            TSVWriter writer(node_file, edge_file);
+            graph.generate(writer, shard, shards);
+        }
+        nodes += read_file(node_file);
+        edges += read_file(edge_file);
+        std::filesystem::remove(node_file);
+        std::filesystem::remove(edge_file);
+    }
+    return {nodes, edges};
+}
+
+
+TEST_CASE("Shard-bounds split the elements into contiguous, nearly equal parts", "[generation][shard]") {
+    for (const Count total : {Count{0}, Count{1}, Count{7}, Count{4096}, Count{1} << 62}) {
+        for (const Count count : {Count{1}, Count{3}, Count{8}}) {
+            REQUIRE(shard_bound(total, 0, count) == 0);
+            REQUIRE(shard_bound(total, count, count) == total);
+            for (Count index = 0; index < count; ++index) {
+                const Count size = shard_bound(total, index + 1, count) - shard_bound(total, index, count);
+                REQUIRE(size >= total / count);
+                REQUIRE(size <= total / count + 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("Shards are parsed from INDEX/COUNT", "[generation][shard]") {
+    Config cfg;
+    parse_shard("2/3", cfg);
+    REQUIRE(cfg.shard_index == 2);
+    REQUIRE(cfg.shard_count == 3);
+
+    for (const std::string invalid : {"3/3", "-1/3", "0/0", "1", "a/3", "1/"})
+        REQUIRE_THROWS_AS(parse_shard(invalid, cfg), std::invalid_argument);
+}
+
+TEST_CASE("Concatenated shards are identical to a single run", "[generation][shard]") {
+    InputModel input = tiny_input();
+    GraphModel graph(input, 3, 42);
+
+    SECTION("All edges") {
+        const auto single = generate_shards(graph, 1);
+        REQUIRE(!single.second.empty());
+        REQUIRE(generate_shards(graph, 3) == single);
+    }
+    SECTION("Simple graph") {
+        graph.enable_simple_graph();
+        const auto single = generate_shards(graph, 1);
+        REQUIRE(!single.second.empty());
+        REQUIRE(generate_shards(graph, 3) == single);
+    }
+}
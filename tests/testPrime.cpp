@@ -31,6 +31,26 @@ TEST_CASE("Edge-Cases: Numbers <=1 will be defined as non-primes", "[prime]") {
     REQUIRE(is_prime(-30232123) == false);
 }
 
+TEST_CASE("Test the primality of numbers beyond 2^31", "[prime]") {
+    REQUIRE(is_prime(2147483647LL) == true);
+    REQUIRE(is_prime(4294967311LL) == true);
+    REQUIRE(is_prime(10000000019LL) == true);
+    REQUIRE(is_prime(2305843009213693951LL) == true);
+    REQUIRE(is_prime(9223372036854775783LL) == true);
+
+    REQUIRE(is_prime(4294967297LL) == false);
+    REQUIRE(is_prime(10000000001LL) == false);
+    REQUIRE(is_prime(2147483647LL * 2147483629LL) == false);
+    // Strong pseudoprimes to several small bases
+    REQUIRE(is_prime(3215031751LL) == false);
+    REQUIRE(is_prime(3825123056546413051LL) == false);
+}
+
+TEST_CASE("Miller-Rabin agrees with trial division", "[prime]") {
+    for (long long n = 1000001; n < 1100000; n += 2)
+        REQUIRE(miller_rabin(static_cast<uint64_t>(n)) == naive_prime(n));
+}
+
 TEST_CASE("Benchmarks on Prime-Number Detection", "[prime]") {
     SECTION( "Hard-Coded Benchmarks" ) {
         BENCHMARK("Constant-Checks"){
@@ -42,6 +62,15 @@ TEST_CASE("Benchmarks on Prime-Number Detection", "[prime]") {
         BENCHMARK("Larger Primes"){
             return is_prime(73381507);
         };
+        BENCHMARK("64-Bit Primes"){
+            return is_prime(10000000019LL);
+        };
+        BENCHMARK("Next Prime after 10^10"){
+            long long p = 10000000000LL;
+            while (!is_prime(p))
+                ++p;
+            return p;
+        };
     }
 
     SECTION( "Randomized Benchmarks" ) {
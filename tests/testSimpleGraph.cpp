@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/SimpleGraph.cpp"
+
+// Uniform edges between the given number of nodes, including self-loops.
+static std::vector<Edge> random_edges(const Count count, const NodeID nodes, const uint64_t key) {
+    CounterRng rng(key);
+    std::vector<Edge> edges;
+    for (Count i = 0; i < count; ++i) {
+        const auto start = static_cast<NodeID>(rng.below(nodes));
+        edges.push_back(Edge{start, static_cast<NodeID>(rng.below(nodes))});
+    }
+    return edges;
+}
+
+TEST_CASE("Self-loops and duplicates are replaced", "[simple]") {
+    const NodeID nodes = 300;
+    std::vector<Edge> edges = random_edges(20000, nodes, 1);
+    const std::vector<Edge> original = edges;
+
+    const SimpleGraphStats stats = make_simple(edges, 2, [&](Count, CounterRng &rng) {
+        return static_cast<NodeID>(rng.below(nodes));
+    });
+
+    REQUIRE(stats.self_loops > 0);
+    REQUIRE(stats.duplicates > 0);
+    REQUIRE(stats.dropped == 0);
+
+    // Replacements keep the start-node of the rejected edge.
+    std::set<std::pair<NodeID, NodeID> > seen;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const Edge &edge = edges[i];
+        REQUIRE(edge.start == original[i].start);
+        REQUIRE(edge.start != edge.end);
+        REQUIRE(seen.emplace(edge.start, edge.end).second);
+    }
+
+    // The first occurrence of an edge is kept at its position.
+    std::set<std::pair<NodeID, NodeID> > first;
+    for (size_t i = 0; i < original.size(); ++i) {
+        const Edge &edge = original[i];
+        if (edge.start != edge.end && first.emplace(edge.start, edge.end).second) {
+            REQUIRE(edges[i].start == edge.start);
+            REQUIRE(edges[i].end == edge.end);
+        }
+    }
+}
+
+TEST_CASE("Edges without a simple replacement are dropped", "[simple]") {
+    // Every node has only 2 possible edges without a self-loop to the other 2 of 3 nodes.
+    std::vector<Edge> edges = random_edges(10, 3, 3);
+    const std::vector<Edge> original = edges;
+    const SimpleGraphStats stats = make_simple(edges, 4, [](Count, CounterRng &rng) {
+        return static_cast<NodeID>(rng.below(3));
+    });
+
+    std::vector<Count> starts(3, 0);
+    for (const Edge &edge : original)
+        ++starts[edge.start];
+    Count possible = 0;
+    for (const Count count : starts)
+        possible += std::min<Count>(count, 2);
+
+    Count kept = 0;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (edges[i].start == NO_EDGE.start) { continue; }
+        REQUIRE(edges[i].start == original[i].start);
+        ++kept;
+    }
+    REQUIRE(kept == possible);
+    REQUIRE(stats.dropped == 10 - possible);
+}
+
+TEST_CASE("Buckets are given by the start-node", "[simple]") {
+    REQUIRE(simple_buckets(0) == 1);
+    REQUIRE(simple_buckets(SIMPLE_BUCKET_EDGES) == 1);
+    REQUIRE(simple_buckets(SIMPLE_BUCKET_EDGES + 1) == 2);
+
+    std::vector<Count> sizes(7, 0);
+    for (NodeID node = 0; node < 70000; ++node) {
+        const Count bucket = simple_bucket(node, 7);
+        REQUIRE(bucket >= 0);
+        REQUIRE(bucket < 7);
+        ++sizes[bucket];
+    }
+    for (const Count size : sizes)
+        REQUIRE(std::abs(size - 10000) < 500);
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/SortingWriter.cpp"
+
+// Keeps all passed edges in memory.
+class CollectingWriter : public GraphWriter {
+public:
+    std::vector<std::pair<Index, Edge> > edges;
+    bool finished = false;
+
+    void writeEdges(const EdgeBatch &batch) override {
+        REQUIRE(batch.first == static_cast<Count>(this->edges.size() - this->color_start(batch.color_id)));
+        for (const Edge &edge : batch.edges)
+            this->edges.emplace_back(batch.color_id, edge);
+    }
+
+    void finish() override { this->finished = true; }
+
+private:
+    size_t color_start(const Index color_id) const {
+        return std::find_if(this->edges.begin(), this->edges.end(),
+                            [color_id](const auto &e) { return e.first == color_id; }) - this->edges.begin();
+    }
+};
+
+static void check_sorted_output(const size_t memory_budget, const Count nbr_edges) {
+    auto collecting = std::make_unique<CollectingWriter>();
+    CollectingWriter &output = *collecting;
+    SortingWriter writer(std::move(collecting), memory_budget, "");
+
+    // Two colors of random edges, passed in batches like the generator does.
+    CounterRng rng(5);
+    std::vector<std::pair<Index, Edge> > expected;
+    for (Index color_id = 0; color_id < 2; ++color_id) {
+        const Edgecolor color = "color" + std::to_string(color_id);
+        for (Count first = 0; first < nbr_edges; first += 4096) {
+            std::vector<Edge> batch;
+            for (Count i = first; i < std::min(nbr_edges, first + 4096); ++i)
+                batch.push_back(Edge{static_cast<NodeID>(rng.below(1000)), static_cast<NodeID>(rng.below(1000))});
+            for (const Edge &edge : batch)
+                expected.emplace_back(color_id, edge);
+            writer.writeEdges(EdgeBatch{color, color_id, first, batch});
+        }
+    }
+    writer.finish();
+
+    std::sort(expected.begin(), expected.end(), [](const auto &l, const auto &r) {
+        return l.first < r.first || (l.first == r.first && edge_less(l.second, r.second));
+    });
+    REQUIRE(output.finished);
+    REQUIRE(output.edges.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(output.edges[i].first == expected[i].first);
+        REQUIRE(output.edges[i].second.start == expected[i].second.start);
+        REQUIRE(output.edges[i].second.end == expected[i].second.end);
+    }
+}
+
+TEST_CASE("Edges are sorted in memory", "[sort]") {
+    check_sorted_output(64 << 20, 50000);
+}
+
+TEST_CASE("Edges are sorted with spilled runs", "[sort]") {
+    // The smallest buffer holds 2^16 edges, so every color is spilled in several runs.
+    check_sorted_output(1, 300000);
+}
+
+TEST_CASE("Many spilled runs are merged in several passes", "[sort]") {
+    // More than 16 runs of 2^16 edges per color need an intermediate merge pass.
+    check_sorted_output(1, 40 * 65536 + 123);
+}
+
+TEST_CASE("Edges written concurrently are sorted with spilled runs", "[sort]") {
+    // The threads fill the next buffer while a full one is spilled.
+    auto collecting = std::make_unique<CollectingWriter>();
+    CollectingWriter &output = *collecting;
+    SortingWriter writer(std::move(collecting), 1, "");
+
+    const Count blocks = 100;
+    std::vector<Edge> expected;
+    for (Count block = 0; block < blocks; ++block) {
+        CounterRng rng(block);
+        for (int i = 0; i < 4096; ++i)
+            expected.push_back(Edge{static_cast<NodeID>(rng.below(1000)), static_cast<NodeID>(rng.below(1000))});
+    }
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(4)
+    for (Count block = 0; block < blocks; ++block) {
+        const std::span<const Edge> batch(expected.data() + block * 4096, 4096);
+        writer.writeEdges(EdgeBatch{"color", 0, block * 4096, batch});
+    }
+    writer.finish();
+
+    std::sort(expected.begin(), expected.end(), edge_less);
+    REQUIRE(output.edges.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(output.edges[i].second.start == expected[i].start);
+        REQUIRE(output.edges[i].second.end == expected[i].end);
+    }
+}
+
+
+// Read back the edges of a binary edge-file as (color, edge) pairs, see testWriter.cpp.
+std::vector<std::pair<Index, Edge> > read_binary_edges(const std::string &path);
+
+TEST_CASE("Sorted edges are passed from the first position of the schema", "[sort][binary]") {
+    const std::string nodes = (std::filesystem::temp_directory_path() / "graphgen-test-sorted-nodes.bin").string();
+    const std::string edges = (std::filesystem::temp_directory_path() / "graphgen-test-sorted-edges.bin").string();
+
+    GraphSchema schema;
+    schema.colors = {{"a", 4096, 1000}};
+    SortingWriter writer(std::make_unique<BinaryWriter>(nodes, edges), 64 << 20, "");
+    writer.begin(schema);
+
+    CounterRng rng(7);
+    std::vector<Edge> batch;
+    for (int i = 0; i < 1000; ++i)
+        batch.push_back(Edge{static_cast<NodeID>(rng.below(100)), static_cast<NodeID>(rng.below(100))});
+    writer.writeEdges(EdgeBatch{"a", 0, 4096, batch});
+    writer.finish();
+
+    std::sort(batch.begin(), batch.end(), edge_less);
+    const std::vector<std::pair<Index, Edge> > written = read_binary_edges(edges);
+    REQUIRE(written.size() == batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        REQUIRE(written[i].second.start == batch[i].start);
+        REQUIRE(written[i].second.end == batch[i].end);
+    }
+
+    std::filesystem::remove(nodes);
+    std::filesystem::remove(edges);
+}
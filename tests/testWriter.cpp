@@ -0,0 +1,384 @@
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "../include/BinaryIO.h"
+#include "../src/Writer.cpp"
+
+// Read back the edges of a binary edge-file as (color, edge) pairs.
+std::vector<std::pair<Index, Edge> > read_binary_edges(const std::string &path) {
+    BinaryIn in(path);
+    REQUIRE(in.get<uint64_t>() == BINARY_EDGES_MAGIC);
+    REQUIRE(in.get<uint64_t>() == BINARY_GRAPH_VERSION);
+    const auto colors = in.get<uint64_t>();
+    for (uint64_t i = 0; i < colors; ++i)
+        in.get_string();
+    std::vector<std::pair<Index, Edge> > edges;
+    for (const EdgeRecord &record : in.view_array<EdgeRecord>())
+        edges.emplace_back(record.color, Edge{static_cast<NodeID>(record.start), static_cast<NodeID>(record.end)});
+    REQUIRE(in.position() == in.size());
+    return edges;
+}
+
+// Decompress a written file into a plain copy next to it, returns the path of the copy.
+static std::string plain_copy(const std::string &path, const Compression compression) {
+    std::ifstream file(path, std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string out = content;
+    if (compression != Compression::NONE) {
+        REQUIRE(detect_compression(content) == compression);
+        const std::unique_ptr<Decompressor> decompressor = Decompressor::create(compression, content);
+        out.clear();
+        char buffer[4096];
+        for (size_t n; (n = decompressor->read(buffer, sizeof(buffer))) > 0;)
+            out.append(buffer, n);
+    }
+    const std::string copy = path + ".plain";
+    std::ofstream(copy, std::ios::binary | std::ios::trunc).write(out.data(), static_cast<std::streamsize>(out.size()));
+    return copy;
+}
+
+TEST_CASE("Binary writer places batches by their position", "[binary]") {
+    const std::string nodes = (std::filesystem::temp_directory_path() / "graphgen-test-nodes.bin").string();
+    const std::string edges = (std::filesystem::temp_directory_path() / "graphgen-test-edges.bin").string();
+
+    // A shard starting at position 8192 of color "a", and color "b" with edges left out at its end.
+    GraphSchema schema;
+    schema.colors = {{"a", 8192, 3 * 4096}, {"b", 0, 5000}};
+    schema.types = {{"x", 10, 3}, {"y", 13, 2}};
+
+    std::map<Count, std::vector<Edge> > batches;
+    for (Count first = 8192; first < 8192 + 3 * 4096; first += 4096)
+        for (Count i = 0; i < 4096; ++i)
+            batches[first].push_back(Edge{first + i, i});
+
+    BinaryWriter writer(nodes, edges);
+    REQUIRE_FALSE(writer.ordered());
+    writer.begin(schema);
+    // Batches of a color may arrive in any order.
+    for (auto it = batches.rbegin(); it != batches.rend(); ++it)
+        writer.writeEdges(EdgeBatch{"a", 0, it->first, it->second});
+    const std::vector<Edge> b_edges{{1, 2}, {3, 4}};
+    writer.writeEdges(EdgeBatch{"b", 1, 0, b_edges});
+    for (NodeID id = 10; id < 15; ++id)
+        writer.writeNode(id < 13 ? "x" : "y", id);
+    writer.finish();
+
+    const std::vector<std::pair<Index, Edge> > written = read_binary_edges(edges);
+    REQUIRE(written.size() == 3 * 4096 + 2);
+    for (Count i = 0; i < 3 * 4096; ++i) {
+        REQUIRE(written[i].first == 0);
+        REQUIRE(written[i].second.start == 8192 + i);
+    }
+    REQUIRE(written[3 * 4096].first == 1);
+    REQUIRE(written[3 * 4096 + 1].second.end == 4);
+
+    BinaryIn in(nodes);
+    REQUIRE(in.get<uint64_t>() == BINARY_NODES_MAGIC);
+    in.get<uint64_t>();
+    REQUIRE(in.get<uint64_t>() == 2);
+    REQUIRE(in.get_string() == "x");
+    REQUIRE(in.get_string() == "y");
+    const std::span<const NodeRecord> records = in.view_array<NodeRecord>();
+    REQUIRE(records.size() == 5);
+    for (size_t i = 0; i < records.size(); ++i) {
+        REQUIRE(records[i].id == 10 + i);
+        REQUIRE(records[i].type == (i < 3 ? 0u : 1u));
+    }
+
+    std::filesystem::remove(nodes);
+    std::filesystem::remove(edges);
+}
+
+// Write the nodes of two types once node by node and once by ranges, the ranges span several chunks of 65536 nodes.
+template<typename Writer>
+static std::pair<std::string, std::string> write_node_ranges(const std::string &extension) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::string single = (dir / ("graphgen-test-single-nodes" + extension)).string();
+    const std::string ranges = (dir / ("graphgen-test-range-nodes" + extension)).string();
+    const std::string edges = (dir / ("graphgen-test-range-edges" + extension)).string();
+
+    GraphSchema schema;
+    schema.colors = {{"a", 0, 0}};
+    schema.types = {{"x", 3, 150000}, {"y", 150003, 7}};
+    for (const bool by_range : {false, true}) {
+        Writer writer(by_range ? ranges : single, edges);
+        writer.begin(schema);
+        for (const GraphSchema::Type &type : schema.types) {
+            if (by_range)
+                writer.writeNodeRange(type.name, type.first, type.first + type.count);
+            else
+                for (NodeID id = type.first; id < type.first + type.count; ++id)
+                    writer.writeNode(type.name, id);
+        }
+        writer.finish();
+    }
+
+    const auto read = [](const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+    std::pair<std::string, std::string> written{read(single), read(ranges)};
+    for (const std::string &path : {single, ranges, edges})
+        std::filesystem::remove(path);
+    return written;
+}
+
+TEST_CASE("Node ranges are written like single nodes", "[tsv][binary]") {
+    const auto [tsv_single, tsv_ranges] = write_node_ranges<TSVWriter>(".tsv");
+    REQUIRE(tsv_ranges == tsv_single);
+    REQUIRE(tsv_ranges.starts_with("3\tx\n4\tx\n"));
+    REQUIRE(tsv_ranges.ends_with("150002\tx\n150003\ty\n"
+                                 "150004\ty\n150005\ty\n150006\ty\n150007\ty\n150008\ty\n150009\ty\n"));
+
+    const auto [binary_single, binary_ranges] = write_node_ranges<BinaryWriter>(".bin");
+    REQUIRE(binary_ranges == binary_single);
+}
+
+// Compressed files are streamed with the counts of the schema in their header. If fewer edges are written, the
+//      stored header block is replaced by the real counts.
+static void check_compressed_binary(const Compression compression) {
+    const std::string nodes = (std::filesystem::temp_directory_path() / "graphgen-test-packed-nodes.bin").string();
+    const std::string edges = (std::filesystem::temp_directory_path() / "graphgen-test-packed-edges.bin").string();
+
+    GraphSchema schema;
+    schema.colors = {{"a", 0, 10}, {"b", 0, 4}};
+    schema.types = {{"x", 0, 3}};
+    {
+        BinaryWriter writer(nodes, edges, OutputOptions{{}, compression, 0});
+        writer.begin(schema);
+        const std::vector<Edge> a_edges{{0, 1}, {1, 2}, {2, 0}};
+        const std::vector<Edge> b_edges{{2, 1}, {1, 0}};
+        writer.writeEdges(EdgeBatch{"a", 0, 0, a_edges});
+        writer.writeEdges(EdgeBatch{"b", 1, 0, b_edges});
+        writer.writeNodeRange("x", 0, 3);
+        writer.finish();
+    }
+
+    const std::string plain_edges = plain_copy(edges, compression);
+    const std::vector<std::pair<Index, Edge> > written = read_binary_edges(plain_edges);
+    REQUIRE(written.size() == 5);
+    REQUIRE(written[2].first == 0);
+    REQUIRE(written[2].second.start == 2);
+    REQUIRE(written[3].first == 1);
+    REQUIRE(written[4].second.start == 1);
+
+    const std::string plain_nodes = plain_copy(nodes, compression);
+    BinaryIn in(plain_nodes);
+    REQUIRE(in.get<uint64_t>() == BINARY_NODES_MAGIC);
+    in.get<uint64_t>();
+    REQUIRE(in.get<uint64_t>() == 1);
+    REQUIRE(in.get_string() == "x");
+    REQUIRE(in.view_array<NodeRecord>().size() == 3);
+
+    for (const std::string &path : {nodes, edges, plain_nodes, plain_edges})
+        std::filesystem::remove(path);
+}
+
+#ifdef GRAPHGEN_HAVE_ZLIB
+TEST_CASE("Gzip-compressed binary output gets the written counts", "[binary][compression]") {
+    check_compressed_binary(Compression::GZIP);
+}
+#endif
+
+#ifdef GRAPHGEN_HAVE_ZSTD
+TEST_CASE("Zstd-compressed binary output gets the written counts", "[binary][compression]") {
+    check_compressed_binary(Compression::ZSTD);
+}
+#endif
+
+TEST_CASE("TSV writer writes unordered batches in the order of their positions", "[tsv]") {
+    const std::string nodes = (std::filesystem::temp_directory_path() / "graphgen-test-nodes.tsv").string();
+    const std::string edges = (std::filesystem::temp_directory_path() / "graphgen-test-edges.tsv").string();
+    {
+        TSVWriter writer(nodes, edges);
+        GraphSchema schema;
+        schema.colors = {{"knows", 2, 3}};
+        writer.begin(schema);
+        REQUIRE_FALSE(writer.ordered());
+
+        // The later batch waits until the earlier one has been written.
+        const std::vector<Edge> second{{-7, 1234567890123}};
+        const std::vector<Edge> first{{0, 1}, {10, 20}};
+        std::thread later([&] { writer.writeEdges(EdgeBatch{"knows", 0, 4, second}); });
+        writer.writeEdges(EdgeBatch{"knows", 0, 2, first});
+        later.join();
+        writer.writeNodeRange("person", 98, 101);
+        writer.finish();
+    }
+
+    std::ifstream edge_file(edges);
+    std::ifstream node_file(nodes);
+    const std::string edge_text((std::istreambuf_iterator<char>(edge_file)), std::istreambuf_iterator<char>());
+    const std::string node_text((std::istreambuf_iterator<char>(node_file)), std::istreambuf_iterator<char>());
+    REQUIRE(edge_text == "0\t1\tknows\n10\t20\tknows\n-7\t1234567890123\tknows\n");
+    REQUIRE(node_text == "98\tperson\n99\tperson\n100\tperson\n");
+
+    std::filesystem::remove(nodes);
+    std::filesystem::remove(edges);
+}
+
+TEST_CASE("Partitioned writer splits the output by color and ID-range", "[partition]") {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "graphgen-test-partitions";
+    std::filesystem::create_directories(dir);
+    const std::string nodes = (dir / "nodes.tsv").string();
+    const std::string edges = (dir / "edges.tsv").string();
+    REQUIRE(PartitionedWriter::partition_path(edges, "has/tag", 3, 12) == (dir / "edges.has_tag.part-03.tsv").string());
+
+    // Nodes 10 to 19 in the partitions [10, 15) and [15, 20).
+    GraphSchema schema;
+    schema.colors = {{"a", 0, 4}, {"b", 0, 2}};
+    schema.types = {{"x", 10, 10}};
+    schema.first_node = 10;
+    schema.nbr_nodes = 10;
+    {
+        PartitionedWriter writer(OutputFormat::TSV, nodes, edges, true, 2);
+        writer.begin(schema);
+        REQUIRE_FALSE(writer.ordered());
+
+        // Every file keeps the order of the positions, even if the batches arrive out of order.
+        const std::vector<Edge> second{{19, 10}, {11, 12}};
+        const std::vector<Edge> first{{16, 17}, {10, 11}};
+        std::thread later([&] { writer.writeEdges(EdgeBatch{"a", 0, 2, second}); });
+        writer.writeEdges(EdgeBatch{"a", 0, 0, first});
+        later.join();
+        const std::vector<Edge> b_edges{{12, 13}, {13, 14}};
+        writer.writeEdges(EdgeBatch{"b", 1, 0, b_edges});
+        writer.writeNodeRange("x", 10, 20);
+        writer.finish();
+    }
+
+    const auto read = [&dir](const std::string &name) {
+        std::ifstream file(dir / name);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+    REQUIRE(read("edges.a.part-0.tsv") == "10\t11\ta\n11\t12\ta\n");
+    REQUIRE(read("edges.a.part-1.tsv") == "16\t17\ta\n19\t10\ta\n");
+    REQUIRE(read("edges.b.part-0.tsv") == "12\t13\tb\n13\t14\tb\n");
+    REQUIRE(read("edges.b.part-1.tsv").empty());
+    REQUIRE(read("nodes.part-0.tsv") == "10\tx\n11\tx\n12\tx\n13\tx\n14\tx\n");
+    REQUIRE(read("nodes.part-1.tsv") == "15\tx\n16\tx\n17\tx\n18\tx\n19\tx\n");
+    REQUIRE(read("edges.manifest.tsv") == "# kind\tfile\tcolor\tfirst_id\tlast_id\trecords\n"
+                                          "nodes\tnodes.part-0.tsv\t*\t10\t14\t5\n"
+                                          "nodes\tnodes.part-1.tsv\t*\t15\t19\t5\n"
+                                          "edges\tedges.a.part-0.tsv\ta\t10\t14\t2\n"
+                                          "edges\tedges.a.part-1.tsv\ta\t15\t19\t2\n"
+                                          "edges\tedges.b.part-0.tsv\tb\t10\t14\t2\n"
+                                          "edges\tedges.b.part-1.tsv\tb\t15\t19\t0\n");
+
+    std::filesystem::remove_all(dir);
+}
+
+// Nodes 10 to 13 in the partitions [10, 12) and [12, 14), the edges of both colors share the files of a partition.
+static void check_partitioned_binary(const Compression compression) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "graphgen-test-binary-partitions";
+    std::filesystem::create_directories(dir);
+    const std::string nodes = (dir / "nodes.bin").string();
+    const std::string edges = (dir / "edges.bin").string();
+
+    GraphSchema schema;
+    schema.colors = {{"a", 0, 3}, {"b", 0, 2}};
+    schema.types = {{"x", 10, 2}, {"y", 12, 2}};
+    schema.first_node = 10;
+    schema.nbr_nodes = 4;
+    {
+        PartitionedWriter writer(OutputFormat::BINARY, nodes, edges, false, 2, OutputOptions{{}, compression, 0});
+        writer.begin(schema);
+        const std::vector<Edge> a_edges{{13, 10}, {10, 11}, {12, 12}};
+        const std::vector<Edge> b_edges{{11, 13}, {12, 10}};
+        writer.writeEdges(EdgeBatch{"a", 0, 0, a_edges});
+        writer.writeEdges(EdgeBatch{"b", 1, 0, b_edges});
+        writer.writeNodeRange("x", 10, 12);
+        writer.writeNodeRange("y", 12, 14);
+        writer.finish();
+    }
+
+    const std::vector<std::pair<Index, Edge> > first = read_binary_edges(plain_copy((dir / "edges.part-0.bin").string(),
+                                                                                    compression));
+    REQUIRE(first.size() == 2);
+    REQUIRE((first[0].first == 0 && first[0].second.start == 10 && first[0].second.end == 11));
+    REQUIRE((first[1].first == 1 && first[1].second.start == 11 && first[1].second.end == 13));
+
+    const std::vector<std::pair<Index, Edge> > second = read_binary_edges(plain_copy((dir / "edges.part-1.bin").string(),
+                                                                                     compression));
+    REQUIRE(second.size() == 3);
+    REQUIRE((second[0].first == 0 && second[0].second.start == 13));
+    REQUIRE((second[1].first == 0 && second[1].second.start == 12));
+    REQUIRE((second[2].first == 1 && second[2].second.start == 12 && second[2].second.end == 10));
+
+    for (Count p = 0; p < 2; ++p) {
+        BinaryIn in(plain_copy((dir / ("nodes.part-" + std::to_string(p) + ".bin")).string(), compression));
+        REQUIRE(in.get<uint64_t>() == BINARY_NODES_MAGIC);
+        in.get<uint64_t>();
+        REQUIRE(in.get<uint64_t>() == 2);
+        REQUIRE(in.get_string() == "x");
+        REQUIRE(in.get_string() == "y");
+        const std::span<const NodeRecord> records = in.view_array<NodeRecord>();
+        REQUIRE(records.size() == 2);
+        for (size_t i = 0; i < records.size(); ++i) {
+            REQUIRE(records[i].id == 10 + 2 * p + i);
+            REQUIRE(records[i].type == p);
+        }
+    }
+
+    std::ifstream manifest(dir / "edges.manifest.tsv");
+    const std::string text((std::istreambuf_iterator<char>(manifest)), std::istreambuf_iterator<char>());
+    REQUIRE(text == "# kind\tfile\tcolor\tfirst_id\tlast_id\trecords\n"
+                    "nodes\tnodes.part-0.bin\t*\t10\t11\t2\n"
+                    "nodes\tnodes.part-1.bin\t*\t12\t13\t2\n"
+                    "edges\tedges.part-0.bin\t*\t10\t11\t2\n"
+                    "edges\tedges.part-1.bin\t*\t12\t13\t3\n");
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Partitioned writer splits binary output by ID-range", "[partition][binary]") {
+    check_partitioned_binary(Compression::NONE);
+}
+
+#ifdef GRAPHGEN_HAVE_ZSTD
+TEST_CASE("Partitioned writer patches the headers of compressed binary files", "[partition][binary][compression]") {
+    check_partitioned_binary(Compression::ZSTD);
+}
+#endif
+
+#ifdef GRAPHGEN_HAVE_ZSTD
+TEST_CASE("Small compressed blocks are collected in the order of their positions", "[compression]") {
+    const std::string path = (std::filesystem::temp_directory_path() / "graphgen-test-collected.zst").string();
+    const std::string empty = (std::filesystem::temp_directory_path() / "graphgen-test-empty.zst").string();
+    GraphSchema schema;
+    schema.colors = {{"a", 0, 3000}};
+    {
+        BlockOutput output(path, OutputOptions{{}, Compression::ZSTD, 0}, nullptr, 1000);
+        output.begin(schema);
+        // Blocks of one edge each, interleaved by two threads.
+        std::thread odd([&] {
+            for (Count i = 1; i < 3000; i += 2)
+                output.append_edges(0, i, 1, std::to_string(i) + "\n");
+        });
+        for (Count i = 0; i < 3000; i += 2)
+            output.append_edges(0, i, 1, std::to_string(i) + "\n");
+        odd.join();
+        output.close();
+
+        // Empty files still get an (empty) frame.
+        BlockOutput(empty, OutputOptions{{}, Compression::ZSTD, 0}).close();
+    }
+
+    std::string expected;
+    for (Count i = 0; i < 3000; ++i)
+        expected += std::to_string(i) + "\n";
+    const std::string plain = plain_copy(path, Compression::ZSTD);
+    std::ifstream file(plain, std::ios::binary);
+    REQUIRE(std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()) == expected);
+    REQUIRE(std::filesystem::file_size(empty) > 0);
+    const std::string plain_empty = plain_copy(empty, Compression::ZSTD);
+    REQUIRE(std::filesystem::file_size(plain_empty) == 0);
+
+    for (const std::string &p : {path, plain, empty, plain_empty})
+        std::filesystem::remove(p);
+}
+#endif